@@ -0,0 +1,98 @@
+#pragma once
+// ---- Microbenchmark harness (host and V5) ----
+// Times a callable in samples of `iters` back-to-back calls. `iters` is
+// calibrated once so a sample lasts at least Options::min_sample_ns; that
+// keeps a coarse clock (pros::micros() on the brain) well above its
+// resolution. After `warmup` samples are thrown away, `samples` samples are
+// kept and reported as ns/op: min, p50, p90, p99, mean, max.
+// The clock is a template parameter returning nanoseconds, so the same
+// harness runs under std::chrono on the host and pros::micros() on target.
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace bench {
+
+// Keep `v` alive and opaque to the optimizer.
+template <class T> inline void keep(const T& v) { asm volatile("" : : "g"(&v) : "memory"); }
+
+struct Options {
+  uint32_t warmup        = 20;
+  uint32_t samples       = 200;
+  uint64_t min_sample_ns = 20000;  // 20 us per sample
+  uint32_t max_iters     = 1u << 20;
+};
+
+struct Result {
+  const char* name;
+  uint32_t iters, samples;
+  double min, p50, p90, p99, mean, max;  // ns/op
+};
+
+template <class Now>
+class Runner {
+ public:
+  explicit Runner(Now now, Options o = {}) : now_(now), o_(o) {}
+
+  // `op(i)` is one operation; `i` counts up so ops can index varied inputs.
+  template <class Op>
+  const Result& run(const char* name, Op&& op) {
+    time(op, 64);  // fault in code and data before calibrating
+    uint32_t iters = 1;
+    while (iters < o_.max_iters && time(op, iters) < o_.min_sample_ns) iters *= 2;
+
+    for (uint32_t s = 0; s < o_.warmup; ++s) time(op, iters);
+    std::vector<double> ns(o_.samples ? o_.samples : 1);
+    for (double& x : ns) x = (double)time(op, iters) / iters;
+    std::sort(ns.begin(), ns.end());
+
+    Result r{name, iters, (uint32_t)ns.size(), ns.front(), pct(ns, 0.50), pct(ns, 0.90),
+             pct(ns, 0.99), 0.0, ns.back()};
+    for (double x : ns) r.mean += x;
+    r.mean /= ns.size();
+    results_.push_back(r);
+    return results_.back();
+  }
+
+  const std::vector<Result>& results() const { return results_; }
+
+ private:
+  template <class Op>
+  uint64_t time(Op& op, uint32_t iters) {
+    const uint64_t t0 = now_();
+    for (uint32_t i = 0; i < iters; ++i) op(seq_++);
+    return now_() - t0;
+  }
+  static double pct(const std::vector<double>& v, double q) {
+    return v[std::min(v.size() - 1, (size_t)(q * (v.size() - 1) + 0.5))];
+  }
+
+  Now now_;
+  Options o_;
+  uint32_t seq_ = 0;
+  std::vector<Result> results_;
+};
+
+// ---- Reporting ----
+inline void print_table(std::FILE* f, const std::vector<Result>& rs) {
+  std::fprintf(f, "%-24s %9s %9s %9s %9s %9s %8s\n",
+               "benchmark (ns/op)", "min", "p50", "p90", "p99", "mean", "iters");
+  for (const Result& r : rs)
+    std::fprintf(f, "%-24s %9.2f %9.2f %9.2f %9.2f %9.2f %8u\n",
+                 r.name, r.min, r.p50, r.p90, r.p99, r.mean, (unsigned)r.iters);
+}
+
+inline void write_json(std::FILE* f, const char* target, const std::vector<Result>& rs) {
+  std::fprintf(f, "{\n  \"target\": \"%s\",\n  \"unit\": \"ns/op\",\n  \"benchmarks\": [\n", target);
+  for (size_t k = 0; k < rs.size(); ++k) {
+    const Result& r = rs[k];
+    std::fprintf(f, "    {\"name\": \"%s\", \"iters\": %u, \"samples\": %u, \"min\": %.3f, "
+                    "\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"mean\": %.3f, \"max\": %.3f}%s\n",
+                 r.name, (unsigned)r.iters, (unsigned)r.samples, r.min, r.p50, r.p90, r.p99,
+                 r.mean, r.max, k + 1 < rs.size() ? "," : "");
+  }
+  std::fprintf(f, "  ]\n}\n");
+}
+
+} // namespace bench
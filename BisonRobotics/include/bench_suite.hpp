@@ -0,0 +1,187 @@
+#pragma once
+// ---- Drive / odometry benchmark suite ----
+// The same list of hot-path benchmarks for the host (src/bench_main.cpp,
+// `make bench`) and the brain (src/bench_target.cpp, `make BENCH=1`), so
+// numbers from both line up by name. Inputs are fixed pseudo-random tables
+// cycled by the op index, so nothing constant-folds and runs are repeatable.
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "bench.hpp"
+#include "ekf.hpp"
+#include "mat.hpp"
+#include "odom.hpp"
+#include "ring.hpp"
+#include "xdrive.hpp"
+
+namespace bench {
+
+constexpr double TICK_NS = 10e6;  // 10 ms control tick
+
+struct SuiteInputs {
+  static constexpr uint32_t N = 256;  // power of two
+  int    js[N][3];         // fwd, str, rot
+  double wheel[N][4];      // un-normalized wheel mix
+  double inches[N], angle[N];
+  double sPar[N], sPerp[N], heading[N];
+
+  SuiteInputs() {
+    uint32_t s = 0x2545F491u;
+    auto u01 = [&]{ s = s * 1664525u + 1013904223u; return (s >> 8) * (1.0 / 16777216.0); };
+    double h = 0.0;
+    for (uint32_t i = 0; i < N; ++i) {
+      for (int& v : js[i]) v = (int)(u01() * 255.0) - 127;
+      for (double& w : wheel[i]) w = u01() * 500.0 - 250.0;
+      inches[i]  = u01() * 48.0;
+      angle[i]   = (u01() * 6.0 - 3.0) * M_PI;
+      sPar[i]    = u01() * 0.6 - 0.1;   // ~30 in/s at 100 Hz
+      sPerp[i]   = u01() * 0.2 - 0.1;
+      h = Odom2WIMU::wrap(h + u01() * 0.06 - 0.03);
+      heading[i] = h;
+    }
+  }
+};
+
+// Run every benchmark. `zero_sticks` calls drive() with centered sticks, for
+// running on a robot whose motors must not move; the mixing math is still
+// covered by the individual benchmarks.
+template <class Now>
+void run_suite(Runner<Now>& r, bool zero_sticks) {
+  static const SuiteInputs in;
+  constexpr uint32_t M = SuiteInputs::N - 1;
+
+  r.run("deadband", [&](uint32_t i) { keep(xdrive::deadband(in.js[i & M][0])); });
+  r.run("signed_square", [&](uint32_t i) { keep(xdrive::signed_square(in.js[i & M][0])); });
+  r.run("normalize", [&](uint32_t i) {
+    const double* w = in.wheel[i & M];
+    double fl = w[0], fr = w[1], bl = w[2], br = w[3];
+    xdrive::normalize(fl, fr, bl, br);
+    keep(fl); keep(fr); keep(bl); keep(br);
+  });
+  r.run("inches_to_deg", [&](uint32_t i) { keep(xdrive::inches_to_deg(in.inches[i & M])); });
+  r.run("Odom2WIMU::wrap", [&](uint32_t i) { keep(Odom2WIMU::wrap(in.angle[i & M])); });
+
+  // One setpoint per helper tick; the S-curve is the costlier shape.
+  const profile::Profile scurve(xdrive::inches_to_deg(24.0), xdrive::motion_limits().forward);
+  r.run("Profile::at", [&](uint32_t i) { keep(scurve.at(in.inches[i & M] / 24.0 * scurve.duration())); });
+  r.run("Profile::Profile", [&](uint32_t i) {
+    keep(profile::Profile(xdrive::inches_to_deg(in.inches[i & M]), xdrive::motion_limits().forward));
+  });
+
+  Odom2WIMU odom(OdomConfig{3.0, 4.0, {0, 0, 0}});
+  r.run("Odom2WIMU::update", [&](uint32_t i) {
+    const uint32_t k = i & M;
+    odom.update(in.sPar[k], in.sPerp[k], in.heading[k]);
+    keep(odom);
+  });
+
+  // The EKF's per-tick work (localize.cpp), and a GPS fix on top of it.
+  ekf::Ekf filt(OdomConfig{3.0, 4.0, {0, 0, 0}});
+  r.run("Ekf::step", [&](uint32_t i) {
+    const uint32_t k = i & M;
+    filt.step(in.sPar[k], in.sPerp[k], in.sPerp[k] * 10.0, in.heading[k], 0.01);
+    keep(filt.pose());
+  });
+  r.run("Ekf::update_gps", [&](uint32_t i) {
+    const uint32_t k = i & M;
+    Pose fix = filt.pose();  // a fix that passes the gate
+    fix.x += in.sPerp[k]; fix.y -= in.sPerp[k]; fix.theta += in.sPerp[k] * 0.01;
+    keep(filt.update_gps(fix, 0.5));
+  });
+
+  // Small dense kernels (mat.hpp): the default kernel (NEON for float on the
+  // brain) next to la::scalar, so the two runs line up by name.
+  la::Mat<8, 8, float> mf{};
+  la::Mat<6, 6, float> spd{};
+  for (uint32_t row = 0; row < 8; ++row)
+    for (uint32_t col = 0; col < 8; ++col)
+      mf(row, col) = static_cast<float>(in.wheel[row * 8 + col][0] / 250.0);
+  for (uint32_t row = 0; row < 6; ++row) {
+    for (uint32_t col = 0; col < 6; ++col) spd(row, col) = 0.5f * (mf(row, col) + mf(col, row));
+    spd(row, row) += 8.0f;  // diagonally dominant: positive definite
+  }
+  la::Mat<6, 6, float> out6;
+  r.run("Mat8f mul", [&](uint32_t i) {
+    mf(0, 0) = static_cast<float>(in.angle[i & M]);
+    keep(mf * mf);
+  });
+  r.run("Mat8f mul scalar", [&](uint32_t i) {
+    mf(0, 0) = static_cast<float>(in.angle[i & M]);
+    keep(la::scalar::mul(mf, mf));
+  });
+  r.run("Mat6f cholesky", [&](uint32_t i) {
+    spd(0, 0) = 8.0f + static_cast<float>(in.inches[i & M]);
+    keep(la::cholesky(spd, out6));
+    keep(out6);
+  });
+  r.run("Mat6f cholesky scalar", [&](uint32_t i) {
+    spd(0, 0) = 8.0f + static_cast<float>(in.inches[i & M]);
+    keep(la::scalar::cholesky(spd, out6));
+    keep(out6);
+  });
+  r.run("Mat6f inverse", [&](uint32_t i) {
+    spd(0, 0) = 8.0f + static_cast<float>(in.inches[i & M]);
+    keep(la::inverse(spd, out6));
+    keep(out6);
+  });
+  r.run("Mat6f inverse scalar", [&](uint32_t i) {
+    spd(0, 0) = 8.0f + static_cast<float>(in.inches[i & M]);
+    keep(la::scalar::inverse(spd, out6));
+    keep(out6);
+  });
+  // The EKF's covariance product, in double (VFP on the brain)
+  la::Mat<8, 8> md{};
+  for (uint32_t row = 0; row < 8; ++row)
+    for (uint32_t col = 0; col < 8; ++col) md(row, col) = mf(row, col);
+  r.run("Mat8d mul", [&](uint32_t i) {
+    md(0, 0) = in.angle[i & M];
+    keep(md * md);
+  });
+
+  // Publishing one sensor snapshot to a consumer and taking it back out.
+  static ring::SpscRing<xdrive::Snapshot, 16> spsc;
+  static ring::MpscRing<xdrive::Snapshot, 16> mpsc;
+  xdrive::Snapshot sn{};
+  r.run("SpscRing push+pop", [&](uint32_t i) {
+    sn.seq = i;
+    spsc.push(sn);
+    spsc.pop(sn);
+    keep(sn);
+  });
+  r.run("MpscRing push+pop", [&](uint32_t i) {
+    sn.seq = i;
+    mpsc.push(sn);
+    mpsc.pop(sn);
+    keep(sn);
+  });
+
+  auto drive = [&](uint32_t k) {
+    if (zero_sticks) xdrive::drive(0, 0, 0, false);
+    else xdrive::drive(in.js[k][0], in.js[k][1], in.js[k][2], false);
+  };
+  r.run("xdrive::drive", [&](uint32_t i) { drive(i & M); });
+
+  // Everything the 10 ms loop computes: shape + mix + motor writes, then one
+  // odometry step.
+  r.run("control_tick", [&](uint32_t i) {
+    const uint32_t k = i & M;
+    drive(k);
+    odom.update(in.sPar[k], in.sPerp[k], in.heading[k]);
+    keep(odom);
+  });
+  if (!zero_sticks) xdrive::drive(0, 0, 0, false);
+}
+
+// p99 of the control_tick benchmark as a share of the 10 ms tick.
+inline double tick_budget_pct(const std::vector<Result>& rs) {
+  for (const Result& r : rs)
+    if (std::string_view(r.name) == "control_tick") return r.p99 / TICK_NS * 100.0;
+  return 0.0;
+}
+
+#ifndef SIM
+// On-target entry point (src/bench_target.cpp, built with `make BENCH=1`).
+void run_on_target();
+#endif
+
+} // namespace bench
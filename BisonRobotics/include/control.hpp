@@ -0,0 +1,60 @@
+#pragma once
+// ---- Fixed-rate control loops ----
+// A Loop calls its callback every `period_ms`, released on
+// pros::Task::delay_until() so the period does not stretch by the callback's
+// own run time. Each Loop has an explicit RTOS priority and either runs in
+// the calling task (run(), e.g. from opcontrol() so it dies with the mode)
+// or in its own task (start()/stop()).
+//
+// Per loop it records, in microseconds:
+//   jitter  : how late the callback started after its release
+//   exec    : callback run time (wcet = worst case)
+//   overrun : the callback finished after the next release
+//   skipped : whole periods dropped after a long overrun (no catch-up burst)
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace control {
+
+struct Stats {
+  uint32_t runs = 0, overruns = 0, skipped = 0;
+  uint32_t exec_last_us = 0, wcet_us = 0;
+  uint32_t jitter_max_us = 0;
+  uint64_t jitter_sum_us = 0;
+  double jitter_avg_us() const { return runs ? (double)jitter_sum_us / runs : 0.0; }
+};
+
+class Loop {
+ public:
+  Loop(const char* name, uint32_t period_ms, uint32_t priority, std::function<void()> fn);
+  Loop(const Loop&) = delete;
+  Loop& operator=(const Loop&) = delete;
+
+  void run();    // loop in the calling task (takes the Loop's priority) until stop()
+  void start();  // loop in a new task named after the Loop (no-op if running)
+  void stop();   // the loop returns at its next release
+
+  const char* name() const { return name_; }
+  uint32_t period_ms() const { return period_; }
+  uint32_t priority() const { return prio_; }
+  bool running() const { return running_; }
+  const Stats& stats() const { return stats_; }
+  void reset_stats() { stats_ = Stats{}; }
+
+ private:
+  const char* name_;
+  uint32_t period_, prio_;
+  std::function<void()> fn_;
+  volatile uint32_t gen_ = 0;
+  volatile bool running_ = false;
+  Stats stats_;
+};
+
+// Every Loop constructed so far, in construction order (for reporting); the
+// registry holds the first MAX_LOOPS.
+constexpr size_t MAX_LOOPS = 16;
+size_t loop_count();
+const Loop& loop(size_t i);
+
+} // namespace control
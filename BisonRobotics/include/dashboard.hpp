@@ -0,0 +1,16 @@
+#pragma once
+// ---- Brain-screen dashboard (LVGL) ----
+// Replaces the llemu text telemetry on the robot when
+// xdrive::LVGL_DASHBOARD is set. It shows a bar and rpm readout per wheel, a
+// velocity trace per wheel, the pose and the control-loop timing. The
+// widgets are refreshed at 30 Hz from the sensor snapshot, but each one is
+// only written (and so invalidated and redrawn by LVGL) when its value moves
+// by more than a threshold. The pose comes from telemetry::publish_pose().
+// SIM builds keep the llemu text telemetry.
+
+namespace dashboard {
+
+void start();  // load the dashboard screen and start its 30 Hz loop
+void stop();
+
+} // namespace dashboard
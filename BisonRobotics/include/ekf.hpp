@@ -0,0 +1,210 @@
+#pragma once
+// ---- EKF pose estimator ----
+// Extended Kalman filter over a fixed 8-element state:
+//   x, y    field position (inches, same frame as Pose)
+//   th      heading (rad, CCW)
+//   vf, vr  robot-frame velocity, +forward / +right (in/s)
+//   w       turn rate (rad/s, CCW)
+//   bg      gyro bias (rad/s)
+//   dh      IMU heading offset: imu heading = th + dh (rad)
+// The IMU heading is integrated gyro, so its error is the integral of the
+// bias (dh' = bg). Without GPS dh only grows from its prior and the filter
+// trusts the IMU heading much like Odom2WIMU; with GPS, dh and bg are
+// observed and the heading stops drifting between fixes.
+//
+// Process model: constant velocity between ticks, with white acceleration
+// noise on vf, vr, w and a random walk on bg. The per-tick sensors enter as
+// scalar updates (independent noise, so no matrix inverse):
+//   tracking wheels  sPar/dt  = vf - L_par*w     sPerp/dt = vr + L_perp*w
+//   gyro             rate     = w + bg
+//   wheel turn rate  rate     = w          (drive encoders, localize.cpp)
+//   IMU heading      heading  = th + dh
+// A GPS fix (x, y, th) is one 3-d update. Its innovation covariance is
+// Cholesky-factored once for both the gain and the gate: a fix whose squared
+// Mahalanobis distance exceeds `gate` is dropped whole.
+// State and covariance live inside the object (la::Mat, mat.hpp): no heap,
+// and a tick (wheels, gyro, predict, heading) is a few thousand flops.
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "mat.hpp"
+#include "odom.hpp"
+
+namespace ekf {
+
+enum : size_t { X, Y, TH, VF, VR, W, BG, DH, N };
+
+// 1-sigma noise levels. Defaults fit 2.75" tracking wheels and the V5 IMU
+// and GPS; the X-drive's own encoders slip far more (localize.cpp).
+struct Noise {
+  double accel     = 400.0;   // in/s^2, unmodelled chassis acceleration
+  double alpha     = 40.0;    // rad/s^2, unmodelled angular acceleration
+  double bias_walk = 1e-4;    // rad/s per sqrt(s)
+  double wheel_frac = 0.05;   // wheel velocity error, fraction of the reading...
+  double wheel_ips  = 0.3;    // ...plus this (in/s; encoder ticks per period)
+  double gyro      = 0.01;    // rad/s
+  double heading   = 0.002;   // rad, IMU heading jitter
+  double gps_heading_per_in = 0.02;  // GPS heading sigma per inch of position sigma...
+  double gps_heading_min    = 0.01;  // ...but at least this (rad)
+  double gate      = 14.2;    // GPS gate, squared Mahalanobis distance (chi-square 3 dof, 99.7%)
+};
+
+// Initial 1-sigma uncertainty. A robot that starts on a known spot uses the
+// defaults; one that gets its pose from the GPS passes large pose sigmas and
+// an unknown IMU offset (the IMU zero is wherever it calibrated).
+struct Prior {
+  double xy = 0.01, th = 0.001;  // in, rad
+  double v  = 0.1,  w  = 0.01;   // in/s, rad/s
+  double bg = 0.002;             // rad/s, bias left after calibration
+  double dh = 0.001;             // rad
+};
+
+// PROS GPS reading (meters from field centre, degrees CW from north) as a
+// Pose: +y is north, theta CCW, so theta = -heading.
+inline Pose gps_pose(double x_m, double y_m, double heading_deg) {
+  constexpr double IN_PER_M = 39.37007874;
+  return {x_m * IN_PER_M, y_m * IN_PER_M, Odom2WIMU::wrap(-heading_deg * M_PI / 180.0)};
+}
+
+class Ekf {
+ public:
+  using Cov = la::Mat<N, N>;
+
+  explicit Ekf(const OdomConfig& c, const Noise& n = {}, const Prior& pr = {})
+      : L_par_(c.L_par), L_perp_(c.L_perp), n_(n) { reset(c.start, pr); }
+
+  void reset(const Pose& start, const Prior& pr = {}) {
+    for (double& v : x_) v = 0.0;
+    P_ = Cov::zero();
+    x_[X] = start.x; x_[Y] = start.y; x_[TH] = start.theta;
+    const double sd[N] = {pr.xy, pr.xy, pr.th, pr.v, pr.v, pr.w, pr.bg, pr.dh};
+    for (size_t i = 0; i < N; ++i) P_(i, i) = sd[i] * sd[i];
+  }
+
+  // Advance the state by dt seconds (midpoint heading, like Odom2WIMU).
+  void predict(double dt) {
+    const double thm = x_[TH] + 0.5 * x_[W] * dt;
+    const double c = std::cos(thm), s = std::sin(thm);
+    const double vf = x_[VF], vr = x_[VR];
+    const double dx = (c * vr - s * vf) * dt, dy = (s * vr + c * vf) * dt;
+
+    // F = I + the terms below; rows X, Y, TH, DH are the only non-trivial ones.
+    Cov F = Cov::identity();
+    F(X, TH) = -dy;  F(X, VR) = c * dt;  F(X, VF) = -s * dt;  F(X, W) = -dy * 0.5 * dt;
+    F(Y, TH) =  dx;  F(Y, VR) = s * dt;  F(Y, VF) =  c * dt;  F(Y, W) =  dx * 0.5 * dt;
+    F(TH, W) = dt;
+    F(DH, BG) = dt;
+
+    x_[X] += dx;
+    x_[Y] += dy;
+    x_[TH] = Odom2WIMU::wrap(x_[TH] + x_[W] * dt);
+    x_[DH] = Odom2WIMU::wrap(x_[DH] + x_[BG] * dt);
+
+    // P = F P F^T + Q
+    P_ = F * P_ * la::transpose(F);
+    const double qa = n_.accel * dt, qw = n_.alpha * dt;
+    P_(VF, VF) += qa * qa;
+    P_(VR, VR) += qa * qa;
+    P_(W, W)   += qw * qw;
+    P_(BG, BG) += n_.bias_walk * n_.bias_walk * dt;
+  }
+
+  // Tracking-wheel travel over the last dt seconds (as fed to Odom2WIMU).
+  void update_wheels(double sPar_in, double sPerp_in, double dt) {
+    if (dt <= 0.0) return;
+    const double zp = sPar_in / dt, zq = sPerp_in / dt;
+    const double rp = n_.wheel_frac * std::abs(zp) + n_.wheel_ips;
+    const double rq = n_.wheel_frac * std::abs(zq) + n_.wheel_ips;
+    update2(VF, 1.0, W, -L_par_, zp - (x_[VF] - L_par_ * x_[W]), rp * rp);
+    update2(VR, 1.0, W,  L_perp_, zq - (x_[VR] + L_perp_ * x_[W]), rq * rq);
+  }
+
+  // Gyro z rate, rad/s CCW.
+  void update_gyro(double rate) {
+    update2(W, 1.0, BG, 1.0, rate - (x_[W] + x_[BG]), n_.gyro * n_.gyro);
+  }
+
+  // Turn rate from the wheels rather than the gyro (no bias), rad/s CCW, with
+  // its 1-sigma error.
+  void update_turn(double rate, double sigma) {
+    update2(W, 1.0, W, 0.0, rate - x_[W], sigma * sigma);
+  }
+
+  // Absolute IMU heading, rad CCW (Odom2WIMU's input).
+  void update_heading(double heading_rad) {
+    update2(TH, 1.0, DH, 1.0, Odom2WIMU::wrap(heading_rad - x_[TH] - x_[DH]),
+            n_.heading * n_.heading);
+  }
+
+  // GPS fix in the Pose frame (gps_pose()) with its position error, inches
+  // (PROS get_error() is meters). False if the fix was gated out.
+  bool update_gps(const Pose& fix, double sigma_in) {
+    constexpr size_t idx[3] = {X, Y, TH};
+    const double sth = std::max(n_.gps_heading_min, n_.gps_heading_per_in * sigma_in);
+    const la::Vec<3> nu{{{fix.x - x_[X]}, {fix.y - x_[Y]}, {Odom2WIMU::wrap(fix.theta - x_[TH])}}};
+
+    // H picks x, y, th: P H^T is three columns of P, S = H P H^T + R
+    la::Mat<N, 3> PHt{};
+    la::Mat<3, 3> S{};
+    for (size_t k = 0; k < 3; ++k) {
+      for (size_t i = 0; i < N; ++i) PHt(i, k) = P_(i, idx[k]);
+      for (size_t j = 0; j < 3; ++j) S(k, j) = P_(idx[k], idx[j]);
+    }
+    S(0, 0) += sigma_in * sigma_in;
+    S(1, 1) += sigma_in * sigma_in;
+    S(2, 2) += sth * sth;
+
+    la::Mat<3, 3> L;
+    if (!la::cholesky(S, L)) return false;
+    const la::Vec<3> w = la::cholesky_solve(L, nu);  // S^-1 nu
+    if (nu(0, 0) * w(0, 0) + nu(1, 0) * w(1, 0) + nu(2, 0) * w(2, 0) > n_.gate) return false;
+
+    // K = P H^T S^-1, solved as K^T = S^-1 (P H^T)^T
+    const la::Mat<3, N> Kt = la::cholesky_solve(L, la::transpose(PHt));
+    for (size_t i = 0; i < N; ++i)
+      x_[i] += Kt(0, i) * nu(0, 0) + Kt(1, i) * nu(1, 0) + Kt(2, i) * nu(2, 0);
+    x_[TH] = Odom2WIMU::wrap(x_[TH]);
+    x_[DH] = Odom2WIMU::wrap(x_[DH]);
+    P_ = P_ - la::transpose(Kt) * la::transpose(PHt);
+    for (size_t r = 0; r < N; ++r)
+      for (size_t c = r + 1; c < N; ++c) P_(r, c) = P_(c, r) = 0.5 * (P_(r, c) + P_(c, r));
+    return true;
+  }
+
+  // One control tick in measurement order: the wheels and gyro describe the
+  // interval just ended, so they refine the velocities before predict()
+  // carries the pose across it; the heading is read at its end.
+  void step(double sPar_in, double sPerp_in, double gyro_rate, double heading_rad, double dt) {
+    update_wheels(sPar_in, sPerp_in, dt);
+    update_gyro(gyro_rate);
+    predict(dt);
+    update_heading(heading_rad);
+  }
+
+  Pose pose() const { return {x_[X], x_[Y], x_[TH]}; }
+  double state(size_t i) const { return x_[i]; }
+  double variance(size_t i) const { return P_(i, i); }
+
+ private:
+  // Scalar update with h = a*e_i + b*e_j (at most two nonzeros), innovation
+  // `innov` and measurement variance `var` (for one state, b = 0 and j = i).
+  void update2(size_t i, double a, size_t j, double b, double innov, double var) {
+    double Ph[N];
+    for (size_t k = 0; k < N; ++k) Ph[k] = a * P_(k, i) + b * P_(k, j);
+    const double S = a * Ph[i] + b * Ph[j] + var;
+    if (!(S > 0.0)) return;
+    const double inv = 1.0 / S;
+    for (size_t k = 0; k < N; ++k) x_[k] += Ph[k] * inv * innov;
+    x_[TH] = Odom2WIMU::wrap(x_[TH]);
+    x_[DH] = Odom2WIMU::wrap(x_[DH]);
+    for (size_t r = 0; r < N; ++r)
+      for (size_t c = r; c < N; ++c) P_(r, c) = P_(c, r) = P_(r, c) - Ph[r] * Ph[c] * inv;
+  }
+
+  double L_par_, L_perp_;
+  Noise n_;
+  double x_[N];
+  Cov P_;
+};
+
+} // namespace ekf
@@ -0,0 +1,110 @@
+#pragma once
+// ---- Holonomic path follower ----
+// Tracks a time-parameterized (x, y, theta) path with Odom2WIMU pose
+// feedback. Translation and heading are controlled independently:
+//   v = v_ref + kP_xy * (p_ref - p)          (field frame, in/s)
+//   w = w_ref + kP_th * wrap(th_ref - th)    (rad/s, CCW)
+// and the result is returned in joystick units for
+// xdrive::drive(fwd, str, rot, true), whose field-centric mapping turns it
+// into robot-frame wheel commands. That mapping takes heading_deg() as CCW
+// degrees, the same sense as Pose::theta.
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "odom.hpp"
+#include "xdrive.hpp"
+
+namespace follow {
+
+struct Waypoint { double t, x, y, theta; };  // s, in, in, rad (CCW)
+
+// Reference pose and field-frame velocity at one instant.
+struct Ref { Pose p; double vx, vy, w; };
+
+// Piecewise-linear path through waypoints with increasing t (not owned; the
+// table usually lives in .rodata). Velocity is the slope of the current
+// segment; theta interpolates the short way round.
+class Path {
+ public:
+  Path(const Waypoint* pts, size_t n): pts_(pts), n_(n) {}
+
+  double duration() const { return n_ ? pts_[n_ - 1].t : 0.0; }
+
+  Ref at(double t) const {
+    if (n_ == 0) return {{0, 0, 0}, 0, 0, 0};
+    if (n_ == 1 || t <= pts_[0].t) return {{pts_[0].x, pts_[0].y, pts_[0].theta}, 0, 0, 0};
+    if (t >= pts_[n_ - 1].t) {
+      const Waypoint& e = pts_[n_ - 1];
+      return {{e.x, e.y, e.theta}, 0, 0, 0};
+    }
+    while (i_ + 1 < n_ && pts_[i_ + 1].t <= t) ++i_;  // t usually only moves forward
+    while (i_ > 0 && pts_[i_].t > t) --i_;
+    const Waypoint& a = pts_[i_];
+    const Waypoint& b = pts_[i_ + 1];
+    const double T = b.t - a.t, u = (t - a.t) / T;
+    const double dth = Odom2WIMU::wrap(b.theta - a.theta);
+    return {{a.x + u * (b.x - a.x), a.y + u * (b.y - a.y), Odom2WIMU::wrap(a.theta + u * dth)},
+            (b.x - a.x) / T, (b.y - a.y) / T, dth / T};
+  }
+
+ private:
+  const Waypoint* pts_;
+  size_t n_;
+  mutable size_t i_ = 0;
+};
+
+struct Gains {
+  double kP_xy = 4.0;          // 1/s
+  double kP_th = 5.0;          // 1/s
+  double max_v_ips = 30.0;     // full stick translation (in/s), as PlantParams
+  double max_w_rps = M_PI;     // full stick rotation (rad/s)
+  double tol_xy = 0.5;         // done when within this (in)...
+  double tol_th = 0.02;        // ...and this (rad) after the path ends
+};
+
+// Joystick command: field frame for xdrive::drive(fwd, str, rot, true) from
+// update(), robot frame for drive(fwd, str, rot, false) from update_robot().
+struct Command { int fwd, str, rot; };
+
+class Follower {
+ public:
+  Follower(const Path& path, const Gains& g = {}): path_(path), g_(g) {}
+
+  // t: seconds since the path started; est: current odometry pose.
+  Command update(const Pose& est, double t) { return control(est, t, 0.0); }
+
+  // Same, but turned into the robot frame with est.theta, for a robot whose
+  // heading comes from the pose estimate rather than the IMU that
+  // drive()'s field-centric mapping reads.
+  Command update_robot(const Pose& est, double t) { return control(est, t, est.theta); }
+
+  // True once the path has ended and the last update() was within tolerance.
+  bool done(double t) const {
+    return t >= path_.duration() && std::hypot(ex_, ey_) <= g_.tol_xy && std::abs(eth_) <= g_.tol_th;
+  }
+  double error_xy() const { return std::hypot(ex_, ey_); }
+  double error_th() const { return eth_; }
+
+ private:
+  Command control(const Pose& est, double t, double frame) {
+    const Ref r = path_.at(t);
+    ex_ = r.p.x - est.x; ey_ = r.p.y - est.y;
+    eth_ = Odom2WIMU::wrap(r.p.theta - est.theta);
+    double vx = r.vx + g_.kP_xy * ex_, vy = r.vy + g_.kP_xy * ey_;
+    const double v = std::hypot(vx, vy);
+    if (v > g_.max_v_ips) { vx *= g_.max_v_ips / v; vy *= g_.max_v_ips / v; }
+    const double w = std::max(-g_.max_w_rps, std::min(g_.max_w_rps, r.w + g_.kP_th * eth_));
+    // Field -> robot frame (as drive()'s field-centric mapping): +right, +forward.
+    const double c = std::cos(frame), s = std::sin(frame);
+    const double vr = vx * c + vy * s, vf = vy * c - vx * s;
+    // drive() rotates +CW; Pose::theta is +CCW.
+    return {xdrive::unshape(vf / g_.max_v_ips * 127.0), xdrive::unshape(vr / g_.max_v_ips * 127.0),
+            xdrive::unshape(-w / g_.max_w_rps * 127.0)};
+  }
+
+  Path path_;
+  Gains g_;
+  double ex_ = 0, ey_ = 0, eth_ = 0;
+};
+
+} // namespace follow
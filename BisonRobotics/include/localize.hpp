@@ -0,0 +1,31 @@
+#pragma once
+// ---- Pose estimator ----
+// Runs the EKF (ekf.hpp) on every sensors-loop sample and publishes its pose
+// with telemetry::publish_pose(), for the dashboard, the serial stream and
+// the SD log. The chassis has no tracking wheels, so the four drive encoders
+// stand in for them: X-drive forward kinematics give forward and strafe
+// travel at the centre (L_par = L_perp = 0) and the turn rate, with much more
+// slip noise than a tracking wheel. The IMU adds rate and heading once
+// calibrated, and the GPS (xdrive::GPS_PORT) absolute fixes, weighted by its
+// get_error(). With neither, the heading is the wheels' alone.
+//
+// Without a GPS the pose starts at `start` and the IMU zero is its heading.
+// With one, `start` is only a guess: the first fixes set the pose and the
+// filter learns the IMU's offset from the field.
+#include <cstdint>
+#include "odom.hpp"
+
+namespace localize {
+
+struct Stats {
+  uint32_t ticks = 0, dropped = 0;  // samples used / lost while the loop fell 16 behind
+  uint32_t gps_fixes = 0, gps_rejected = 0;
+};
+
+// Start the "pose" loop (xdrive::start_sensors() must be running).
+void start(const Pose& start = {0, 0, 0});
+void stop();
+bool running();
+const Stats& stats();
+
+} // namespace localize
@@ -0,0 +1,64 @@
+#pragma once
+// ---- SD-card run logger ----
+// Records every sensors-loop tick (the telemetry records of telemetry.hpp:
+// wheels, pose, loop timing) to the brain's microSD card, so every match and
+// practice run can be replayed with `telem_decode /usd/brlog_03.bin`.
+//
+// fwrite() on FAT can stall for tens of milliseconds, so the sensors loop
+// never touches the card. Its tick packs records into one of two static
+// buffers; when that buffer is full it is handed to a low-priority writer
+// task and the tick continues in the other one. The writer cuts the full
+// buffer into LZ4-compressed BLOCK frames (wire.hpp) and writes them in one
+// fwrite(). If the writer still holds the other buffer when the next one
+// fills, ticks are dropped and counted, not queued.
+//
+// Files are LOG_FILES slots, brlog_00.bin .. brlog_15.bin, used in turn
+// (brlog.idx holds the last slot): each start() and every MAX_FILE_BYTES
+// moves to the next slot, overwriting the oldest log. The next slot is
+// opened while the current one still has room, so rotating is a pointer swap.
+#include <cstddef>
+#include <cstdint>
+#include "xdrive.hpp"
+
+namespace logger {
+
+constexpr const char* LOG_DIR = "/usd/";
+constexpr unsigned LOG_FILES = 16;
+constexpr uint32_t MAX_FILE_BYTES = 4u << 20;  // ~15 min at 100 Hz compressed
+constexpr size_t BUFFER_BYTES = 8192;           // per buffer, ~1 s of ticks
+
+// Things that happen between samples, posted from any task and written as
+// EVENT records (wire.hpp) at the next sensors tick.
+enum class Event : uint8_t {
+  MODE = 1,      // a: 0 disabled, 1 autonomous, 2 opcontrol
+  MOVE_END = 2,  // a: ms, b: settled
+};
+
+struct Stats {
+  uint32_t ticks = 0, dropped_ticks = 0;  // ticks logged / lost to a busy writer
+  uint32_t events = 0, dropped_events = 0;
+  uint32_t buffers = 0, blocks = 0;       // buffers handed over, frames written
+  uint32_t files = 0, write_errors = 0;
+  uint32_t write_max_us = 0;              // slowest fwrite()
+  uint64_t raw_bytes = 0, file_bytes = 0;
+};
+
+// Open the next slot under `dir` and start logging from the sensors loop
+// (xdrive::start_sensors() must be running). False without an SD card or if
+// the file cannot be created.
+bool start(const char* dir = LOG_DIR);
+// Write out everything logged so far and sync the file; the logger keeps
+// running. For disabled(), so a match is on the card before power-off.
+void flush();
+// Stop logging, write the rest and close the files (waits for the writer).
+void stop();
+
+// Any task, never blocks: queued in an MpscRing (ring.hpp) of 32 that the
+// sensors loop drains. Ignored while the logger is stopped.
+void event(Event kind, int32_t a = 0, int32_t b = 0);
+
+bool running();
+const char* path();  // file being written, or the last one ("" before start())
+const Stats& stats();
+
+} // namespace logger
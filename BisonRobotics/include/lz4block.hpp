@@ -0,0 +1,114 @@
+#pragma once
+// ---- LZ4 block format ----
+// Compressor and decompressor for the LZ4 *block* format (no frame header),
+// so output decodes with any LZ4 implementation (LZ4_decompress_safe). The
+// vendored liblvgl/libs/lz4 ships only lz4.h, and LVGL is built without it,
+// so there is no LZ4 code to link on the brain or the host.
+//
+// Greedy single-probe matcher: far below lz4's ratio on large inputs, but
+// fine for short blocks of repetitive telemetry records, with no heap and a
+// caller-owned hash table.
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace lz4 {
+
+constexpr int HASH_LOG = 10;
+constexpr size_t HASH_SIZE = size_t(1) << HASH_LOG;
+struct Table { uint32_t pos[HASH_SIZE]; };  // 4 KB
+
+// Worst case output size for n input bytes.
+constexpr size_t bound(size_t n) { return n + n / 255 + 16; }
+
+namespace detail {
+constexpr size_t MIN_MATCH = 4, LAST_LITERALS = 5, MF_LIMIT = 12, MAX_OFFSET = 65535;
+
+inline uint32_t read32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+inline uint32_t hash(uint32_t v) { return (v * 2654435761u) >> (32 - HASH_LOG); }
+
+// Length continuation bytes after a 15 in a token nibble.
+inline bool put_len(size_t len, uint8_t* dst, size_t cap, size_t& op) {
+  for (; len >= 255; len -= 255) { if (op >= cap) return false; dst[op++] = 255; }
+  if (op >= cap) return false;
+  dst[op++] = static_cast<uint8_t>(len);
+  return true;
+}
+
+// One sequence: literals [lit, lit + nlit), then a match (mlen 0 = none).
+inline bool put_seq(const uint8_t* lit, size_t nlit, size_t offset, size_t mlen, uint8_t* dst,
+                    size_t cap, size_t& op) {
+  if (op >= cap) return false;
+  const size_t ml = mlen ? mlen - MIN_MATCH : 0;
+  uint8_t& token = dst[op++];
+  token = static_cast<uint8_t>((nlit >= 15 ? 15 : nlit) << 4 | (ml >= 15 ? 15 : ml));
+  if (nlit >= 15 && !put_len(nlit - 15, dst, cap, op)) return false;
+  if (op + nlit > cap) return false;
+  std::memcpy(dst + op, lit, nlit);
+  op += nlit;
+  if (!mlen) return true;
+  if (op + 2 > cap) return false;
+  dst[op++] = static_cast<uint8_t>(offset);
+  dst[op++] = static_cast<uint8_t>(offset >> 8);
+  return ml < 15 || put_len(ml - 15, dst, cap, op);
+}
+} // namespace detail
+
+// Compress src[0, n) into dst; returns the compressed size, or 0 if it does
+// not fit in `cap` bytes.
+inline size_t compress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap, Table& t) {
+  using namespace detail;
+  std::memset(t.pos, 0, sizeof t.pos);  // 0 = empty, else position + 1
+  size_t ip = 0, anchor = 0, op = 0;
+  if (n >= MF_LIMIT + 1) {
+    const size_t limit = n - MF_LIMIT, match_limit = n - LAST_LITERALS;
+    while (ip < limit) {
+      const uint32_t seq = read32(src + ip);
+      uint32_t& slot = t.pos[hash(seq)];
+      const size_t ref = slot;
+      slot = static_cast<uint32_t>(ip + 1);
+      if (!ref || ip - (ref - 1) > MAX_OFFSET || read32(src + ref - 1) != seq) { ++ip; continue; }
+      size_t len = MIN_MATCH;
+      while (ip + len < match_limit && src[ref - 1 + len] == src[ip + len]) ++len;
+      if (!put_seq(src + anchor, ip - anchor, ip - (ref - 1), len, dst, cap, op)) return 0;
+      ip += len;
+      anchor = ip;
+    }
+  }
+  return put_seq(src + anchor, n - anchor, 0, 0, dst, cap, op) ? op : 0;
+}
+
+// Decompress src[0, n) into dst; returns the decompressed size, or -1 if the
+// input is malformed or would overflow `cap`.
+inline long decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap) {
+  size_t ip = 0, op = 0;
+  auto get_len = [&](size_t& len) {
+    uint8_t b;
+    do {
+      if (ip >= n) return false;
+      b = src[ip++];
+      len += b;
+    } while (b == 255);
+    return true;
+  };
+  while (ip < n) {
+    const uint8_t token = src[ip++];
+    size_t lit = token >> 4;
+    if (lit == 15 && !get_len(lit)) return -1;
+    if (ip + lit > n || op + lit > cap) return -1;
+    std::memcpy(dst + op, src + ip, lit);
+    ip += lit; op += lit;
+    if (ip == n) break;  // last sequence has no match
+    if (ip + 2 > n) return -1;
+    const size_t offset = src[ip] | size_t(src[ip + 1]) << 8;
+    ip += 2;
+    size_t ml = token & 15;
+    if (ml == 15 && !get_len(ml)) return -1;
+    ml += detail::MIN_MATCH;
+    if (offset == 0 || offset > op || op + ml > cap) return -1;
+    for (size_t k = 0; k < ml; ++k, ++op) dst[op] = dst[op - offset];  // may overlap
+  }
+  return static_cast<long>(op);
+}
+
+} // namespace lz4
@@ -0,0 +1,305 @@
+#pragma once
+// ---- Fixed-size matrices ----
+// Mat<R, C, T> is a plain row-major T[R][C] aggregate for the small dense
+// math of estimation and control (3x3 up to ~9x9): no heap, no expression
+// templates, every loop bound a template parameter. Everything here is
+// constexpr, so a constant gain or model matrix can be built at compile time.
+//
+// Kernels:
+//   a * b                   product
+//   cholesky(a, l)          a = l * l^T, l lower; false unless a is positive definite
+//   cholesky_solve(l, b)    x with (l * l^T) x = b, for any number of columns
+//   inverse(a, out)         Gauss-Jordan with partial pivoting; false if singular
+//
+// la::scalar holds the reference kernels on every build. On the Cortex-A9
+// (NEON, 4 x f32) products, Cholesky and inverse of float matrices run the
+// la::neon kernels instead, four columns of a row at a time; ARMv7 NEON has
+// no f64 lanes, so double matrices always take the scalar (VFP) path. The
+// NEON kernels only run outside constant evaluation.
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+#if defined(__ARM_NEON) && !defined(__aarch64__)
+  #include <arm_neon.h>
+  #define LA_NEON 1
+#endif
+
+namespace la {
+
+template <size_t R, size_t C, class T = double>
+struct Mat {
+  T a[R][C];
+
+  static constexpr size_t rows = R, cols = C;
+  constexpr T& operator()(size_t r, size_t c) { return a[r][c]; }
+  constexpr const T& operator()(size_t r, size_t c) const { return a[r][c]; }
+
+  static constexpr Mat zero() { return Mat{}; }
+  static constexpr Mat identity() {
+    Mat m{};
+    for (size_t i = 0; i < (R < C ? R : C); ++i) m.a[i][i] = T(1);
+    return m;
+  }
+};
+
+template <size_t N, class T = double> using Vec = Mat<N, 1, T>;
+
+// ---- Element-wise ----
+template <size_t R, size_t C, class T>
+constexpr Mat<R, C, T> operator+(const Mat<R, C, T>& x, const Mat<R, C, T>& y) {
+  Mat<R, C, T> m{};
+  for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j) m.a[i][j] = x.a[i][j] + y.a[i][j];
+  return m;
+}
+
+template <size_t R, size_t C, class T>
+constexpr Mat<R, C, T> operator-(const Mat<R, C, T>& x, const Mat<R, C, T>& y) {
+  Mat<R, C, T> m{};
+  for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j) m.a[i][j] = x.a[i][j] - y.a[i][j];
+  return m;
+}
+
+template <size_t R, size_t C, class T>
+constexpr Mat<R, C, T> operator*(T k, const Mat<R, C, T>& x) {
+  Mat<R, C, T> m{};
+  for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j) m.a[i][j] = k * x.a[i][j];
+  return m;
+}
+
+template <size_t R, size_t C, class T>
+constexpr Mat<C, R, T> transpose(const Mat<R, C, T>& x) {
+  Mat<C, R, T> m{};
+  for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j) m.a[j][i] = x.a[i][j];
+  return m;
+}
+
+namespace detail {
+// GCC builtin (C++17 hosts lack std::is_constant_evaluated()).
+constexpr bool constant_evaluated() { return __builtin_is_constant_evaluated(); }
+
+template <class T> constexpr T abs(T x) { return x < T(0) ? -x : x; }
+
+// std::sqrt at run time; Newton's method when evaluated at compile time.
+template <class T> constexpr T sqrt(T x) {
+  if (!constant_evaluated()) return std::sqrt(x);
+  if (!(x > T(0))) return x == T(0) ? T(0) : std::numeric_limits<T>::quiet_NaN();
+  T r = x > T(1) ? x : T(1);
+  for (int i = 0; i < 100; ++i) {
+    const T next = (r + x / r) / T(2);
+    if (next == r) break;
+    r = next;
+  }
+  return r;
+}
+} // namespace detail
+
+// ---- Reference kernels ----
+namespace scalar {
+
+template <size_t R, size_t C, size_t K, class T>
+constexpr Mat<R, K, T> mul(const Mat<R, C, T>& x, const Mat<C, K, T>& y) {
+  Mat<R, K, T> m{};
+  for (size_t i = 0; i < R; ++i)
+    for (size_t k = 0; k < C; ++k) {
+      const T xik = x.a[i][k];
+      for (size_t j = 0; j < K; ++j) m.a[i][j] += xik * y.a[k][j];
+    }
+  return m;
+}
+
+template <size_t N, class T>
+constexpr bool cholesky(const Mat<N, N, T>& x, Mat<N, N, T>& l) {
+  l = Mat<N, N, T>{};
+  for (size_t j = 0; j < N; ++j) {
+    T d = x.a[j][j];
+    for (size_t k = 0; k < j; ++k) d -= l.a[j][k] * l.a[j][k];
+    if (!(d > T(0))) return false;
+    const T ljj = detail::sqrt(d);
+    l.a[j][j] = ljj;
+    for (size_t i = j + 1; i < N; ++i) {
+      T s = x.a[i][j];
+      for (size_t k = 0; k < j; ++k) s -= l.a[i][k] * l.a[j][k];
+      l.a[i][j] = s / ljj;
+    }
+  }
+  return true;
+}
+
+template <size_t N, class T>
+constexpr bool inverse(const Mat<N, N, T>& x, Mat<N, N, T>& out) {
+  Mat<N, N, T> m = x;
+  out = Mat<N, N, T>::identity();
+  for (size_t p = 0; p < N; ++p) {
+    size_t piv = p;
+    for (size_t r = p + 1; r < N; ++r)
+      if (detail::abs(m.a[r][p]) > detail::abs(m.a[piv][p])) piv = r;
+    if (!(detail::abs(m.a[piv][p]) > T(0))) return false;
+    if (piv != p)
+      for (size_t j = 0; j < N; ++j) {
+        T t = m.a[p][j]; m.a[p][j] = m.a[piv][j]; m.a[piv][j] = t;
+        t = out.a[p][j]; out.a[p][j] = out.a[piv][j]; out.a[piv][j] = t;
+      }
+    const T f = T(1) / m.a[p][p];
+    for (size_t j = 0; j < N; ++j) { m.a[p][j] *= f; out.a[p][j] *= f; }
+    for (size_t r = 0; r < N; ++r) {
+      const T g = m.a[r][p];
+      if (r == p || g == T(0)) continue;
+      for (size_t j = 0; j < N; ++j) { m.a[r][j] -= g * m.a[p][j]; out.a[r][j] -= g * out.a[p][j]; }
+    }
+  }
+  return true;
+}
+
+} // namespace scalar
+
+// ---- NEON kernels (float) ----
+#ifdef LA_NEON
+namespace neon {
+
+inline float hsum(float32x4_t v) {
+  float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+  return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+
+// sum(x[k] * y[k]) for k < n
+inline float dot(const float* x, const float* y, size_t n) {
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  size_t k = 0;
+  for (; k + 4 <= n; k += 4) acc = vmlaq_f32(acc, vld1q_f32(x + k), vld1q_f32(y + k));
+  float s = hsum(acc);
+  for (; k < n; ++k) s += x[k] * y[k];
+  return s;
+}
+
+// dst -= g * src, one row of N floats
+template <size_t N>
+inline void axpy_neg(float (&dst)[N], const float (&src)[N], float g) {
+  for (size_t k = 0; k + 4 <= N; k += 4)
+    vst1q_f32(dst + k, vmlsq_n_f32(vld1q_f32(dst + k), vld1q_f32(src + k), g));
+  for (size_t k = N / 4 * 4; k < N; ++k) dst[k] -= g * src[k];
+}
+
+template <size_t N>
+inline void scale(float (&dst)[N], float f) {
+  for (size_t k = 0; k + 4 <= N; k += 4) vst1q_f32(dst + k, vmulq_n_f32(vld1q_f32(dst + k), f));
+  for (size_t k = N / 4 * 4; k < N; ++k) dst[k] *= f;
+}
+
+// Row i of the product accumulates x[i][k] * (row k of y), four columns at a time.
+template <size_t R, size_t C, size_t K>
+inline Mat<R, K, float> mul(const Mat<R, C, float>& x, const Mat<C, K, float>& y) {
+  Mat<R, K, float> m;
+  for (size_t i = 0; i < R; ++i) {
+    size_t j = 0;
+    for (; j + 4 <= K; j += 4) {
+      float32x4_t acc = vdupq_n_f32(0.0f);
+      for (size_t k = 0; k < C; ++k) acc = vmlaq_n_f32(acc, vld1q_f32(&y.a[k][j]), x.a[i][k]);
+      vst1q_f32(&m.a[i][j], acc);
+    }
+    for (; j < K; ++j) {
+      float s = 0.0f;
+      for (size_t k = 0; k < C; ++k) s += x.a[i][k] * y.a[k][j];
+      m.a[i][j] = s;
+    }
+  }
+  return m;
+}
+
+// Row-oriented: the inner sums are dot products of two rows of l.
+template <size_t N>
+inline bool cholesky(const Mat<N, N, float>& x, Mat<N, N, float>& l) {
+  l = Mat<N, N, float>{};
+  for (size_t j = 0; j < N; ++j) {
+    const float d = x.a[j][j] - dot(l.a[j], l.a[j], j);
+    if (!(d > 0.0f)) return false;
+    const float ljj = std::sqrt(d), inv = 1.0f / ljj;
+    l.a[j][j] = ljj;
+    for (size_t i = j + 1; i < N; ++i) l.a[i][j] = (x.a[i][j] - dot(l.a[i], l.a[j], j)) * inv;
+  }
+  return true;
+}
+
+template <size_t N>
+inline bool inverse(const Mat<N, N, float>& x, Mat<N, N, float>& out) {
+  Mat<N, N, float> m = x;
+  out = Mat<N, N, float>::identity();
+  for (size_t p = 0; p < N; ++p) {
+    size_t piv = p;
+    for (size_t r = p + 1; r < N; ++r)
+      if (std::fabs(m.a[r][p]) > std::fabs(m.a[piv][p])) piv = r;
+    if (!(std::fabs(m.a[piv][p]) > 0.0f)) return false;
+    if (piv != p)
+      for (size_t j = 0; j < N; ++j) {
+        float t = m.a[p][j]; m.a[p][j] = m.a[piv][j]; m.a[piv][j] = t;
+        t = out.a[p][j]; out.a[p][j] = out.a[piv][j]; out.a[piv][j] = t;
+      }
+    const float f = 1.0f / m.a[p][p];
+    scale(m.a[p], f);
+    scale(out.a[p], f);
+    for (size_t r = 0; r < N; ++r) {
+      const float g = m.a[r][p];
+      if (r == p || g == 0.0f) continue;
+      axpy_neg(m.a[r], m.a[p], g);
+      axpy_neg(out.a[r], out.a[p], g);
+    }
+  }
+  return true;
+}
+
+} // namespace neon
+#endif
+
+// ---- Kernels (NEON for float on the brain, else scalar) ----
+template <size_t R, size_t C, size_t K, class T>
+constexpr Mat<R, K, T> operator*(const Mat<R, C, T>& x, const Mat<C, K, T>& y) {
+#ifdef LA_NEON
+  if constexpr (std::is_same<T, float>::value)
+    if (!detail::constant_evaluated()) return neon::mul(x, y);
+#endif
+  return scalar::mul(x, y);
+}
+
+template <size_t N, class T>
+constexpr bool cholesky(const Mat<N, N, T>& x, Mat<N, N, T>& l) {
+#ifdef LA_NEON
+  if constexpr (std::is_same<T, float>::value)
+    if (!detail::constant_evaluated()) return neon::cholesky(x, l);
+#endif
+  return scalar::cholesky(x, l);
+}
+
+template <size_t N, class T>
+constexpr bool inverse(const Mat<N, N, T>& x, Mat<N, N, T>& out) {
+#ifdef LA_NEON
+  if constexpr (std::is_same<T, float>::value)
+    if (!detail::constant_evaluated()) return neon::inverse(x, out);
+#endif
+  return scalar::inverse(x, out);
+}
+
+// Forward then back substitution with the factor from cholesky().
+template <size_t N, size_t K, class T>
+constexpr Mat<N, K, T> cholesky_solve(const Mat<N, N, T>& l, const Mat<N, K, T>& b) {
+  Mat<N, K, T> y{};
+  for (size_t c = 0; c < K; ++c) {
+    for (size_t i = 0; i < N; ++i) {      // l y = b
+      T s = b.a[i][c];
+      for (size_t k = 0; k < i; ++k) s -= l.a[i][k] * y.a[k][c];
+      y.a[i][c] = s / l.a[i][i];
+    }
+    for (size_t i = N; i-- > 0;) {        // l^T x = y
+      T s = y.a[i][c];
+      for (size_t k = i + 1; k < N; ++k) s -= l.a[k][i] * y.a[k][c];
+      y.a[i][c] = s / l.a[i][i];
+    }
+  }
+  return y;
+}
+
+} // namespace la
@@ -1,5 +1,7 @@
 #pragma once
 #include <cmath>
+#include <cstddef>
+#include "odom_batch.hpp"
 struct Pose { double x, y, theta; }; // inches, inches, radians
 
 struct OdomConfig {
@@ -21,6 +23,16 @@ class Odom2WIMU {
     p.y +=  s*dx_r + c*dy_r;
     p.theta = wrap(p.theta + dth);
   }
+  // Same as calling update() for each of n samples (structure-of-arrays input,
+  // vectorized; see odom_batch.hpp). Optional outputs get the pose per sample.
+  void update_batch(const double* sPar_in, const double* sPerp_in, const double* heading_rad,
+                    size_t n, double* x_out = nullptr, double* y_out = nullptr,
+                    double* th_out = nullptr) {
+    odom_batch::State st{p.x, p.y, p.theta, last_h};
+    odom_batch::integrate(cfg.L_par, cfg.L_perp, st, sPar_in, sPerp_in, heading_rad, n,
+                          x_out, y_out, th_out);
+    p = {st.x, st.y, st.theta}; last_h = st.last_h;
+  }
   Pose pose() const { return p; }
   static double wrap(double a){ while(a> M_PI)a-=2*M_PI; while(a<=-M_PI)a+=2*M_PI; return a; }
  private:
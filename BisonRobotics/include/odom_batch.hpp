@@ -0,0 +1,259 @@
+#pragma once
+// Batch (structure-of-arrays) version of Odom2WIMU::update for log replay.
+//
+// Per block of samples:
+//   1. heading deltas dth = wrap(h[i] - h[i-1])       branchless, auto-vectorized
+//   2. midpoint headings thm = theta + 0.5*dth         serial prefix sum
+//   3. sin/cos(thm)                                    explicit SIMD kernel
+//   4. rotate the wheel deltas into the field frame    4-way accumulators
+// The rotation is linear in the wheel offsets, so step 4 only accumulates
+//   A = sum(c*sPerp - s*sPar),  B = sum(s*sPerp + c*sPar),
+//   C = sum(c*dth),             S = sum(s*dth)
+// and any (L_par, L_perp) pair is applied afterwards:
+//   dx = A - L_perp*C - L_par*S,  dy = B - L_perp*S + L_par*C
+// One pass over a log therefore gives the final pose for every config.
+//
+// sincos kernels: AVX (4 x f64) or SSE2 (2 x f64) on hosts, NEON (4 x f32)
+// on the Cortex-A9, scalar otherwise. The f64 kernels agree with std::sin/cos
+// to ~1e-16; the NEON kernel is single precision (~1e-7 per sample).
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX__)
+  #include <immintrin.h>
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON) && !defined(__aarch64__)
+  #include <arm_neon.h>
+#endif
+
+namespace odom_batch {
+
+constexpr size_t BLOCK = 128;  // 4 KB of scratch on the stack per call
+
+// ---- sin/cos ----
+namespace detail {
+  constexpr double TWO_OVER_PI = 0.636619772367581343076;
+  constexpr double PIO2_HI = 1.57079632673412561417e+00;  // first 33 bits of pi/2
+  constexpr double PIO2_LO = 6.07710050650619224932e-11;  // pi/2 - PIO2_HI
+  constexpr double S1 = -1.66666666666666324348e-01, S2 =  8.33333333332248946124e-03,
+                   S3 = -1.98412698298579493134e-04, S4 =  2.75573137070700676789e-06,
+                   S5 = -2.50507602534068634195e-08, S6 =  1.58969099521155010221e-10;
+  constexpr double C1 =  4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03,
+                   C3 =  2.48015872894767294178e-05, C4 = -2.75573143513906633035e-07,
+                   C5 =  2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+
+  // Round to nearest (ties to even) for |x| < 2^51 without a libm call.
+  // Relies on strict IEEE double arithmetic (no -ffast-math).
+  inline double round_nearest(double x) {
+    return (x + 6755399441055744.0) - 6755399441055744.0;  // 1.5*2^52
+  }
+
+  // Reference kernel; the SIMD paths evaluate the same polynomials.
+  inline void sincos1(double x, double& s, double& c) {
+    const double q = round_nearest(x * TWO_OVER_PI);
+    const double r = (x - q * PIO2_HI) - q * PIO2_LO, z = r * r;
+    const double sr = r + r*z*(S1 + z*(S2 + z*(S3 + z*(S4 + z*(S5 + z*S6)))));
+    const double cr = 1.0 - 0.5*z + z*z*(C1 + z*(C2 + z*(C3 + z*(C4 + z*(C5 + z*C6)))));
+    const int k = (int)((int64_t)q & 3);
+    s = (k & 1) ? cr : sr;  c = (k & 1) ? sr : cr;
+    if (k & 2) s = -s;
+    if ((k + 1) & 2) c = -c;
+  }
+} // namespace detail
+
+inline void sincos_block(const double* x, double* s, double* c, size_t n) {
+  using namespace detail;
+  size_t i = 0;
+#if defined(__AVX__)
+  const __m256d k2pi = _mm256_set1_pd(TWO_OVER_PI), hi = _mm256_set1_pd(PIO2_HI),
+                lo = _mm256_set1_pd(PIO2_LO), half = _mm256_set1_pd(0.5), one = _mm256_set1_pd(1.0),
+                sign = _mm256_set1_pd(-0.0);
+  for (; i + 4 <= n; i += 4) {
+    const __m256d v = _mm256_loadu_pd(x + i);
+    const __m256d q = _mm256_round_pd(_mm256_mul_pd(v, k2pi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    const __m256d r = _mm256_sub_pd(_mm256_sub_pd(v, _mm256_mul_pd(q, hi)), _mm256_mul_pd(q, lo));
+    const __m256d z = _mm256_mul_pd(r, r);
+    __m256d ps = _mm256_set1_pd(S6), pc = _mm256_set1_pd(C6);
+    ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(S5)); pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(C5));
+    ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(S4)); pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(C4));
+    ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(S3)); pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(C3));
+    ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(S2)); pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(C2));
+    ps = _mm256_add_pd(_mm256_mul_pd(ps, z), _mm256_set1_pd(S1)); pc = _mm256_add_pd(_mm256_mul_pd(pc, z), _mm256_set1_pd(C1));
+    const __m256d sr = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(r, z), ps));
+    const __m256d cr = _mm256_add_pd(_mm256_sub_pd(one, _mm256_mul_pd(half, z)),
+                                     _mm256_mul_pd(_mm256_mul_pd(z, z), pc));
+    // Quadrant bits -> 64-bit lane masks.
+    const __m128i k  = _mm256_cvtpd_epi32(q);
+    const __m128i b1 = _mm_cmpeq_epi32(_mm_and_si128(k, _mm_set1_epi32(1)), _mm_set1_epi32(1));
+    const __m128i b2 = _mm_slli_epi32(_mm_and_si128(k, _mm_set1_epi32(2)), 30);
+    const __m128i b3 = _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(k, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30);
+    auto widen = [](__m128i m) {
+      return _mm256_castsi256_pd(_mm256_insertf128_si256(
+          _mm256_castsi128_si256(_mm_unpacklo_epi32(m, m)), _mm_unpackhi_epi32(m, m), 1));
+    };
+    const __m256d swap = widen(b1);
+    const __m256d ss = _mm256_and_pd(widen(b2), sign), cs = _mm256_and_pd(widen(b3), sign);
+    _mm256_storeu_pd(s + i, _mm256_xor_pd(_mm256_blendv_pd(sr, cr, swap), ss));
+    _mm256_storeu_pd(c + i, _mm256_xor_pd(_mm256_blendv_pd(cr, sr, swap), cs));
+  }
+#elif defined(__SSE2__)
+  const __m128d k2pi = _mm_set1_pd(TWO_OVER_PI), hi = _mm_set1_pd(PIO2_HI), lo = _mm_set1_pd(PIO2_LO),
+                half = _mm_set1_pd(0.5), one = _mm_set1_pd(1.0), sign = _mm_set1_pd(-0.0),
+                magic = _mm_set1_pd(6755399441055744.0);  // 1.5*2^52: round-to-nearest trick
+  for (; i + 2 <= n; i += 2) {
+    const __m128d v = _mm_loadu_pd(x + i);
+    const __m128d q = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(v, k2pi), magic), magic);
+    const __m128d r = _mm_sub_pd(_mm_sub_pd(v, _mm_mul_pd(q, hi)), _mm_mul_pd(q, lo));
+    const __m128d z = _mm_mul_pd(r, r);
+    __m128d ps = _mm_set1_pd(S6), pc = _mm_set1_pd(C6);
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(S5)); pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(C5));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(S4)); pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(C4));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(S3)); pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(C3));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(S2)); pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(C2));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(S1)); pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(C1));
+    const __m128d sr = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(r, z), ps));
+    const __m128d cr = _mm_add_pd(_mm_sub_pd(one, _mm_mul_pd(half, z)), _mm_mul_pd(_mm_mul_pd(z, z), pc));
+    // Duplicate each lane's int32 quadrant into both halves of its 64-bit lane.
+    const __m128i k  = _mm_shuffle_epi32(_mm_cvtpd_epi32(q), _MM_SHUFFLE(1, 1, 0, 0));
+    const __m128d swap = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(k, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    const __m128d ss = _mm_and_pd(_mm_castsi128_pd(_mm_slli_epi32(_mm_and_si128(k, _mm_set1_epi32(2)), 30)), sign);
+    const __m128d cs = _mm_and_pd(_mm_castsi128_pd(_mm_slli_epi32(
+                           _mm_and_si128(_mm_add_epi32(k, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30)), sign);
+    const __m128d so = _mm_or_pd(_mm_and_pd(swap, cr), _mm_andnot_pd(swap, sr));
+    const __m128d co = _mm_or_pd(_mm_and_pd(swap, sr), _mm_andnot_pd(swap, cr));
+    _mm_storeu_pd(s + i, _mm_xor_pd(so, ss));
+    _mm_storeu_pd(c + i, _mm_xor_pd(co, cs));
+  }
+#elif defined(__ARM_NEON) && !defined(__aarch64__)
+  // ARMv7 NEON has no f64 lanes: evaluate in single precision.
+  const float32x4_t k2pi = vdupq_n_f32(0.636619772f), magic = vdupq_n_f32(12582912.0f),  // 1.5*2^23
+                    dp1 = vdupq_n_f32(1.5703125f), dp2 = vdupq_n_f32(4.837512969970703125e-4f),
+                    dp3 = vdupq_n_f32(7.54978995489188216e-8f), half = vdupq_n_f32(0.5f), one = vdupq_n_f32(1.0f);
+  for (; i + 4 <= n; i += 4) {
+    const float xv[4] = {(float)x[i], (float)x[i+1], (float)x[i+2], (float)x[i+3]};
+    const float32x4_t v = vld1q_f32(xv);
+    const float32x4_t q = vsubq_f32(vaddq_f32(vmulq_f32(v, k2pi), magic), magic);
+    float32x4_t r = vmlsq_f32(v, q, dp1);
+    r = vmlsq_f32(r, q, dp2);
+    r = vmlsq_f32(r, q, dp3);
+    const float32x4_t z = vmulq_f32(r, r);
+    float32x4_t ps = vmlaq_f32(vdupq_n_f32(8.3321608736E-3f), z, vdupq_n_f32(-1.9515295891E-4f));
+    ps = vmlaq_f32(vdupq_n_f32(-1.6666654611E-1f), z, ps);
+    float32x4_t pc = vmlaq_f32(vdupq_n_f32(-1.388731625493765E-3f), z, vdupq_n_f32(2.443315711809948E-5f));
+    pc = vmlaq_f32(vdupq_n_f32(4.166664568298827E-2f), z, pc);
+    const float32x4_t sr = vmlaq_f32(r, vmulq_f32(r, z), ps);
+    const float32x4_t cr = vmlaq_f32(vmlsq_f32(one, half, z), vmulq_f32(z, z), pc);
+    const int32x4_t k = vcvtq_s32_f32(q);
+    const uint32x4_t swap = vtstq_s32(k, vdupq_n_s32(1));
+    const uint32x4_t sneg = vtstq_s32(k, vdupq_n_s32(2));
+    const uint32x4_t cneg = vtstq_s32(vaddq_s32(k, vdupq_n_s32(1)), vdupq_n_s32(2));
+    float32x4_t so = vbslq_f32(swap, cr, sr), co = vbslq_f32(swap, sr, cr);
+    so = vbslq_f32(sneg, vnegq_f32(so), so);
+    co = vbslq_f32(cneg, vnegq_f32(co), co);
+    float sf[4], cf[4];
+    vst1q_f32(sf, so); vst1q_f32(cf, co);
+    for (int j = 0; j < 4; ++j) { s[i+j] = sf[j]; c[i+j] = cf[j]; }
+  }
+#endif
+  for (; i < n; ++i) sincos1(x[i], s[i], c[i]);
+}
+
+// Branchless equivalent of Odom2WIMU::wrap for |a| < ~2^51: maps to (-pi, pi].
+inline double wrap_fast(double a) {
+  a -= 2.0 * M_PI * detail::round_nearest(a * (0.5 / M_PI));
+  return a <= -M_PI ? a + 2.0 * M_PI : a;
+}
+
+// Rolling odometry state (what Odom2WIMU keeps between updates).
+struct State { double x, y, theta, last_h; };
+
+// Config-independent sums over a run of samples (see header comment).
+struct Sums {
+  double A = 0, B = 0, C = 0, S = 0;
+  double dx(double L_par, double L_perp) const { return A - L_perp*C - L_par*S; }
+  double dy(double L_par, double L_perp) const { return B - L_perp*S + L_par*C; }
+};
+
+// Accumulate n samples into `sums`, advancing theta/last_h in `st` (x, y untouched).
+inline void accumulate(State& st, const double* sPar, const double* sPerp, const double* heading,
+                       size_t n, Sums& sums) {
+  double dth[BLOCK], thm[BLOCK], sn[BLOCK], cs[BLOCK];
+  for (size_t i0 = 0; i0 < n; i0 += BLOCK) {
+    const size_t m = (n - i0 < BLOCK) ? n - i0 : BLOCK;
+    const double* h = heading + i0;
+    dth[0] = wrap_fast(h[0] - st.last_h);
+    for (size_t j = 1; j < m; ++j) dth[j] = wrap_fast(h[j] - h[j-1]);
+    st.last_h = h[m-1];
+
+    double th = st.theta;
+    for (size_t j = 0; j < m; ++j) { thm[j] = th + 0.5*dth[j]; th += dth[j]; }
+    st.theta = wrap_fast(th);
+
+    sincos_block(thm, sn, cs, m);
+
+    const double* sp = sPar + i0;
+    const double* sq = sPerp + i0;
+    double a[4] = {0,0,0,0}, b[4] = {0,0,0,0}, cc[4] = {0,0,0,0}, ss[4] = {0,0,0,0};
+    size_t j = 0;
+    for (; j + 4 <= m; j += 4)
+      for (size_t u = 0; u < 4; ++u) {
+        a[u]  += cs[j+u]*sq[j+u] - sn[j+u]*sp[j+u];
+        b[u]  += sn[j+u]*sq[j+u] + cs[j+u]*sp[j+u];
+        cc[u] += cs[j+u]*dth[j+u];
+        ss[u] += sn[j+u]*dth[j+u];
+      }
+    for (; j < m; ++j) {
+      a[0]  += cs[j]*sq[j] - sn[j]*sp[j];
+      b[0]  += sn[j]*sq[j] + cs[j]*sp[j];
+      cc[0] += cs[j]*dth[j];
+      ss[0] += sn[j]*dth[j];
+    }
+    sums.A += (a[0] + a[1]) + (a[2] + a[3]);
+    sums.B += (b[0] + b[1]) + (b[2] + b[3]);
+    sums.C += (cc[0] + cc[1]) + (cc[2] + cc[3]);
+    sums.S += (ss[0] + ss[1]) + (ss[2] + ss[3]);
+  }
+}
+
+// Integrate n samples for one config. If x_out/y_out/th_out are given, the
+// pose after every sample is written there (serial prefix sum, slower).
+inline void integrate(double L_par, double L_perp, State& st,
+                      const double* sPar, const double* sPerp, const double* heading, size_t n,
+                      double* x_out = nullptr, double* y_out = nullptr, double* th_out = nullptr) {
+  if (!x_out && !y_out && !th_out) {
+    Sums sums;
+    accumulate(st, sPar, sPerp, heading, n, sums);
+    st.x += sums.dx(L_par, L_perp);
+    st.y += sums.dy(L_par, L_perp);
+    return;
+  }
+  double dth[BLOCK], thm[BLOCK], sn[BLOCK], cs[BLOCK];
+  for (size_t i0 = 0; i0 < n; i0 += BLOCK) {
+    const size_t m = (n - i0 < BLOCK) ? n - i0 : BLOCK;
+    const double* h = heading + i0;
+    dth[0] = wrap_fast(h[0] - st.last_h);
+    for (size_t j = 1; j < m; ++j) dth[j] = wrap_fast(h[j] - h[j-1]);
+    st.last_h = h[m-1];
+
+    double th = st.theta;
+    for (size_t j = 0; j < m; ++j) { thm[j] = th + 0.5*dth[j]; th += dth[j]; }
+
+    sincos_block(thm, sn, cs, m);
+
+    double x = st.x, y = st.y;
+    for (size_t j = 0; j < m; ++j) {
+      const double dx_r = sPerp[i0+j] - L_perp*dth[j];
+      const double dy_r = sPar[i0+j]  + L_par*dth[j];
+      x += cs[j]*dx_r - sn[j]*dy_r;
+      y += sn[j]*dx_r + cs[j]*dy_r;
+      if (x_out)  x_out[i0+j]  = x;
+      if (y_out)  y_out[i0+j]  = y;
+      if (th_out) th_out[i0+j] = wrap_fast(thm[j] + 0.5*dth[j]);
+    }
+    st.x = x; st.y = y; st.theta = wrap_fast(th);
+  }
+}
+
+} // namespace odom_batch
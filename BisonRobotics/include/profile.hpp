@@ -0,0 +1,96 @@
+#pragma once
+// ---- Motion profiles ----
+// Rest-to-rest, time-optimal profiles for one axis under velocity,
+// acceleration and (optionally) jerk limits. jerk == 0 gives a trapezoid;
+// jerk > 0 gives a 7-segment S-curve whose acceleration ramps instead of
+// stepping, which keeps the wheels from breaking traction at the start and
+// end. When the distance is too short to reach a limit the profile drops
+// that phase (triangle / no constant-acceleration segment).
+//
+// A profile is a few doubles: no heap, and at() is a segment lookup plus a
+// cubic, cheap enough to sample every control tick.
+#include <algorithm>
+#include <cmath>
+
+namespace profile {
+
+struct Limits {
+  double v;      // max velocity     (units/s)
+  double a;      // max acceleration (units/s^2)
+  double j = 0;  // max jerk (units/s^3), 0 = trapezoid
+};
+
+struct State { double p, v, a; };
+
+class Profile {
+ public:
+  Profile() = default;  // zero length, done at t = 0
+
+  Profile(double distance, const Limits& lim) {
+    const double D = std::abs(distance);
+    dir_ = distance < 0 ? -1.0 : 1.0;
+    if (D <= 0.0 || lim.v <= 0.0 || lim.a <= 0.0) return;
+    const double V = lim.v, A = lim.a, J = lim.j;
+
+    // Peak velocity vp, peak acceleration ap, jerk-ramp time tj and
+    // constant-acceleration time tc of each (symmetric) ramp.
+    double vp, ap, tj, tc;
+    if (J <= 0.0) {
+      vp = std::min(V, std::sqrt(D * A));
+      ap = A; tj = 0.0; tc = vp / A;
+    } else {
+      // Ramp distance is vp*(2*tj + tc)/2 with tc = vp/ap - tj.
+      ap = std::min(A, std::sqrt(V * J));  // ramp too short to reach A
+      tj = ap / J;
+      vp = V;
+      if (vp * (vp / ap + tj) > D) {
+        // Cannot cruise: largest vp whose two ramps fit in D.
+        vp = 0.5 * (-ap * tj + std::sqrt(ap * ap * tj * tj + 4.0 * D * ap));
+        if (vp < ap * tj) {  // not even A: pure jerk ramps
+          tj = std::cbrt(D / (2.0 * J));
+          ap = J * tj;
+          vp = ap * tj;
+        }
+      }
+      tc = vp / ap - tj;
+    }
+    const double tv = D / vp - (2.0 * tj + tc);
+
+    const double dur[7] = {tj, tc, tj, tv, tj, tc, tj};
+    const double jerk[7] = {J, 0, -J, 0, -J, 0, J};
+    const double acc[7] = {J > 0 ? 0 : ap, ap, ap, 0, J > 0 ? 0 : -ap, -ap, -ap};
+    double t = 0.0, p = 0.0, v = 0.0;
+    for (int i = 0; i < 7; ++i) {
+      const double d = std::max(0.0, dur[i]);
+      seg_[i] = {t, p, v, acc[i], jerk[i]};
+      p += v * d + acc[i] * d * d / 2.0 + jerk[i] * d * d * d / 6.0;
+      v += acc[i] * d + jerk[i] * d * d / 2.0;
+      t += d;
+    }
+    end_ = t;
+    dist_ = D;
+  }
+
+  double duration() const { return end_; }
+  double distance() const { return dir_ * dist_; }
+
+  // Setpoint t seconds after the start (clamped to the ends).
+  State at(double t) const {
+    if (t >= end_) return {dir_ * dist_, 0.0, 0.0};
+    if (t <= 0.0) return {0.0, 0.0, 0.0};
+    int i = 6;
+    while (i > 0 && t < seg_[i].t0) --i;
+    const Seg& s = seg_[i];
+    const double d = t - s.t0;
+    return {dir_ * (s.p + s.v * d + s.a * d * d / 2.0 + s.j * d * d * d / 6.0),
+            dir_ * (s.v + s.a * d + s.j * d * d / 2.0),
+            dir_ * (s.a + s.j * d)};
+  }
+
+ private:
+  struct Seg { double t0, p, v, a, j; };
+  Seg seg_[7] = {};
+  double end_ = 0.0, dist_ = 0.0, dir_ = 1.0;
+};
+
+} // namespace profile
@@ -0,0 +1,122 @@
+#pragma once
+// ---- Lock-free rings ----
+// Fixed-size queues for passing samples between tasks without pros::Mutex:
+// no call ever blocks, so a high-priority producer (the sensors loop) never
+// waits on, or inherits the latency of, a lower-priority consumer. A push
+// into a full ring fails and the caller counts the drop; a pop from an empty
+// ring fails.
+//
+//   SpscRing<T, N> : one producer task, one consumer task. Wait-free.
+//   MpscRing<T, N> : any number of producer tasks, one consumer. Producers
+//                    claim a slot with one compare-exchange, retried only if
+//                    another producer claimed it first; the consumer never
+//                    retries. An item shows up once its producer has finished
+//                    writing it, so a producer preempted mid-push delays
+//                    later items but never blocks anyone.
+//
+// N is a power of two, T trivially copyable. Indices are free-running u32s
+// (wrap is harmless), so every atomic is a plain load/store or one
+// ldrex/strex pair on the Cortex-A9. Producer and consumer indices sit on
+// separate 32-byte cache lines.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace ring {
+
+constexpr size_t CACHE_LINE = 32;  // Cortex-A9 L1
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "rings need lock-free 32-bit atomics");
+
+template <class T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value, "SpscRing<T> copies T bytewise");
+
+ public:
+  // Producer
+  bool push(const T& v) {
+    const uint32_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) == N) return false;
+    buf_[h & (N - 1)] = v;
+    head_.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer
+  bool pop(T& out) {
+    const uint32_t t = tail_.load(std::memory_order_relaxed);
+    if (t == head_.load(std::memory_order_acquire)) return false;
+    out = buf_[t & (N - 1)];
+    tail_.store(t + 1, std::memory_order_release);
+    return true;
+  }
+  // Drop everything queued (consumer side).
+  void clear() { tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release); }
+
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  alignas(CACHE_LINE) std::atomic<uint32_t> head_{0};  // written by the producer
+  alignas(CACHE_LINE) std::atomic<uint32_t> tail_{0};  // written by the consumer
+  alignas(CACHE_LINE) T buf_[N];
+};
+
+template <class T, size_t N>
+class MpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value, "MpscRing<T> copies T bytewise");
+
+ public:
+  MpscRing() {
+    for (uint32_t i = 0; i < N; ++i) slots_[i].seq.store(i, std::memory_order_relaxed);
+  }
+  MpscRing(const MpscRing&) = delete;
+  MpscRing& operator=(const MpscRing&) = delete;
+
+  // Any task. A slot is free for position p when its seq == p, and holds
+  // the item for p once seq == p + 1.
+  bool push(const T& v) {
+    uint32_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& s = slots_[pos & (N - 1)];
+      const int32_t diff = static_cast<int32_t>(s.seq.load(std::memory_order_acquire) - pos);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          s.value = v;
+          s.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }                        // lost the slot: pos now holds the new head
+      } else if (diff < 0) {
+        return false;            // full: the consumer has not freed it yet
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Consumer only.
+  bool pop(T& out) {
+    const uint32_t pos = tail_.load(std::memory_order_relaxed);
+    Slot& s = slots_[pos & (N - 1)];
+    if (static_cast<int32_t>(s.seq.load(std::memory_order_acquire) - (pos + 1)) < 0) return false;
+    out = s.value;
+    s.seq.store(pos + N, std::memory_order_release);  // free for the next lap
+    tail_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  struct Slot { std::atomic<uint32_t> seq; T value; };
+  alignas(CACHE_LINE) std::atomic<uint32_t> head_{0};  // shared by producers
+  alignas(CACHE_LINE) std::atomic<uint32_t> tail_{0};  // consumer only
+  alignas(CACHE_LINE) Slot slots_[N];
+};
+
+} // namespace ring
@@ -0,0 +1,158 @@
+#pragma once
+// ---- Compile-time spline routes ----
+// A route is a constexpr list of (x, y, theta) waypoints. route::build()
+// expands it while compiling into a follow::Waypoint table:
+//   1. a Catmull-Rom spline through the waypoints (x, y), heading blended
+//      linearly along each span;
+//   2. N samples spaced evenly by arc length;
+//   3. a time for each sample from the fastest speed that respects the
+//      velocity, acceleration, lateral-acceleration and turn-rate limits
+//      (forward/backward pass, starts and ends at rest).
+// The table is plain .rodata and follow::Path plays it directly, so the
+// robot does no path generation at all. Declare routes constexpr and
+// static_assert route::check() so a route that leaves the field or bends
+// tighter than the limits fails the build.
+#include <array>
+#include <cstddef>
+#include "follow.hpp"
+
+namespace route {
+
+struct Point { double x, y, theta; };  // in, in, rad (CCW), as Pose
+
+// Defaults leave the follower headroom below full stick (30 in/s, pi rad/s)
+// for its corrections; past that, mix() scales the wheels and it falls behind.
+struct Limits {
+  double v     = 18.0;   // in/s
+  double a     = 36.0;   // in/s^2
+  double a_lat = 24.0;   // in/s^2 sideways (caps speed to sqrt(a_lat / curvature))
+  double w     = 1.5;    // rad/s heading rate
+  double kappa = 0.5;    // 1/in, tightest allowed bend (check())
+};
+
+// Field-relative box the whole route must stay inside (inches).
+struct Bounds { double x_min, x_max, y_min, y_max; };
+
+namespace detail {
+
+constexpr double abs(double v) { return v < 0 ? -v : v; }
+constexpr double min(double a, double b) { return a < b ? a : b; }
+
+// std::sqrt is not constexpr in C++17.
+constexpr double sqrt(double v) {
+  if (v <= 0.0) return 0.0;
+  double r = v > 1.0 ? v : 1.0;
+  for (int i = 0; i < 64; ++i) {
+    const double n = 0.5 * (r + v / r);
+    if (n == r) break;
+    r = n;
+  }
+  return r;
+}
+
+// Uniform Catmull-Rom on span [p1, p2]: value, first and second derivative.
+struct Cubic { double p, d1, d2; };
+constexpr Cubic catmull(double p0, double p1, double p2, double p3, double u) {
+  const double a = -0.5 * p0 + 1.5 * p1 - 1.5 * p2 + 0.5 * p3;
+  const double b = p0 - 2.5 * p1 + 2.0 * p2 - 0.5 * p3;
+  const double c = -0.5 * p0 + 0.5 * p2;
+  return {((a * u + b) * u + c) * u + p1, (3.0 * a * u + 2.0 * b) * u + c, 6.0 * a * u + 2.0 * b};
+}
+
+template <size_t W>
+struct Spline {
+  const std::array<Point, W>& pts;
+  constexpr const Point& at(long i) const { return pts[i < 0 ? 0 : i >= (long)W ? W - 1 : i]; }
+
+  // Span k (between waypoints k and k+1) at u in [0, 1].
+  struct Eval { double x, y, theta, speed, kappa; };
+  constexpr Eval eval(size_t k, double u) const {
+    const Point &p0 = at((long)k - 1), &p1 = at(k), &p2 = at(k + 1), &p3 = at(k + 2);
+    const Cubic x = catmull(p0.x, p1.x, p2.x, p3.x, u);
+    const Cubic y = catmull(p0.y, p1.y, p2.y, p3.y, u);
+    const double sp = sqrt(x.d1 * x.d1 + y.d1 * y.d1);
+    const double k_ = sp > 1e-9 ? abs(x.d1 * y.d2 - y.d1 * x.d2) / (sp * sp * sp) : 0.0;
+    return {x.p, y.p, p1.theta + u * (p2.theta - p1.theta), sp, k_};
+  }
+};
+
+constexpr size_t FINE = 64;  // integration steps per span for arc length
+
+} // namespace detail
+
+// Expand `pts` into N samples (N >= 2, at least 2 waypoints).
+template <size_t N, size_t W>
+constexpr std::array<follow::Waypoint, N> build(const std::array<Point, W>& pts,
+                                                const Limits& lim = {}) {
+  static_assert(N >= 2 && W >= 2, "a route needs 2+ waypoints and 2+ samples");
+  const detail::Spline<W> sp{pts};
+  constexpr size_t M = (W - 1) * detail::FINE;
+
+  // Cumulative arc length at each fine step (trapezoid rule on |r'(u)|).
+  std::array<double, M + 1> len{};
+  for (size_t i = 1; i <= M; ++i) {
+    const size_t k0 = (i - 1) / detail::FINE, k1 = i / detail::FINE < W - 1 ? i / detail::FINE : W - 2;
+    const double u0 = (double)(i - 1 - k0 * detail::FINE) / detail::FINE;
+    const double u1 = (double)(i - k1 * detail::FINE) / detail::FINE;
+    len[i] = len[i - 1] + 0.5 * (sp.eval(k0, u0).speed + sp.eval(k1, u1).speed) / detail::FINE;
+  }
+  const double total = len[M];
+  const double ds = total / (N - 1);
+
+  // Resample evenly in arc length; v_max from curvature and turn rate.
+  std::array<follow::Waypoint, N> out{};
+  std::array<double, N> v{}, kap{};
+  size_t j = 0;
+  for (size_t n = 0; n < N; ++n) {
+    const double s = n == N - 1 ? total : n * ds;
+    while (j + 1 < M && len[j + 1] < s) ++j;
+    const double f = len[j + 1] > len[j] ? (s - len[j]) / (len[j + 1] - len[j]) : 0.0;
+    const double g = j + f;
+    size_t k = (size_t)(g / detail::FINE);
+    if (k > W - 2) k = W - 2;
+    const auto e = sp.eval(k, (g - (double)(k * detail::FINE)) / detail::FINE);
+    out[n] = {0.0, e.x, e.y, e.theta};
+    kap[n] = e.kappa;
+  }
+  for (size_t n = 0; n < N; ++n) {
+    double vm = lim.v;
+    if (kap[n] > 1e-9) vm = detail::min(vm, detail::sqrt(lim.a_lat / kap[n]));
+    const double dth = n + 1 < N ? detail::abs(out[n + 1].theta - out[n].theta) : 0.0;
+    if (dth > 1e-12) vm = detail::min(vm, lim.w * ds / dth);
+    v[n] = vm;
+  }
+  v[0] = v[N - 1] = 0.0;
+  for (size_t n = 1; n < N; ++n) v[n] = detail::min(v[n], detail::sqrt(v[n - 1] * v[n - 1] + 2.0 * lim.a * ds));
+  for (size_t n = N - 1; n-- > 0;) v[n] = detail::min(v[n], detail::sqrt(v[n + 1] * v[n + 1] + 2.0 * lim.a * ds));
+  for (size_t n = 1; n < N; ++n) out[n].t = out[n - 1].t + 2.0 * ds / (v[n - 1] + v[n]);
+  return out;
+}
+
+// Largest curvature along the spline (1/in), checked on the fine grid.
+template <size_t W>
+constexpr double max_curvature(const std::array<Point, W>& pts) {
+  const detail::Spline<W> sp{pts};
+  double k = 0.0;
+  for (size_t s = 0; s + 1 < W; ++s)
+    for (size_t i = 0; i <= detail::FINE; ++i) {
+      const double c = sp.eval(s, (double)i / detail::FINE).kappa;
+      k = c > k ? c : k;
+    }
+  return k;
+}
+
+template <size_t N>
+constexpr bool in_bounds(const std::array<follow::Waypoint, N>& tab, const Bounds& b) {
+  for (const follow::Waypoint& p : tab)
+    if (p.x < b.x_min || p.x > b.x_max || p.y < b.y_min || p.y > b.y_max) return false;
+  return true;
+}
+
+// Everything a route must satisfy to ship.
+template <size_t N, size_t W>
+constexpr bool check(const std::array<Point, W>& pts, const std::array<follow::Waypoint, N>& tab,
+                     const Bounds& b, const Limits& lim = {}) {
+  return in_bounds(tab, b) && max_curvature(pts) <= lim.kappa;
+}
+
+} // namespace route
@@ -0,0 +1,28 @@
+#pragma once
+// ---- Autonomous routes ----
+// Expanded at compile time (route.hpp); each table is static_assert-checked
+// against the field and the route limits. Coordinates are inches from the
+// starting pose, +y forward, +x right, theta CCW in radians.
+#include <cmath>
+#include "route.hpp"
+
+namespace routes {
+
+// Start-relative region the robot may use (starting near the left wall,
+// facing downfield).
+constexpr route::Bounds FIELD{-12.0, 120.0, -12.0, 132.0};
+constexpr route::Limits LIMITS{};
+
+// Sweep to (12, 24) facing right: the opening forward + strafe + turn of
+// autonomous() as one curved move.
+constexpr std::array<route::Point, 4> CURVE_TO_GOAL_PTS{{
+  { 0.0,  0.0,  0.0},
+  { 1.0, 12.0, -0.3},
+  { 5.0, 20.0, -0.9},
+  {12.0, 24.0, -M_PI / 2},
+}};
+constexpr auto CURVE_TO_GOAL = route::build<64>(CURVE_TO_GOAL_PTS, LIMITS);
+static_assert(route::check(CURVE_TO_GOAL_PTS, CURVE_TO_GOAL, FIELD, LIMITS),
+              "CURVE_TO_GOAL leaves the field or bends too tightly");
+
+} // namespace routes
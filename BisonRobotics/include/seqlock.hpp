@@ -0,0 +1,42 @@
+#pragma once
+// ---- Seqlock ----
+// One writer publishes a T; any number of readers take consistent copies
+// without locks and without ever blocking the writer. The sequence number is
+// odd while a write is in progress; a reader that overlaps a write (sequence
+// odd, or changed during its copy) retries. T must be trivially copyable.
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+template <class T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock<T> copies T bytewise");
+
+ public:
+  void store(const T& v) {
+    const uint32_t s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    data_ = v;
+    seq_.store(s + 2, std::memory_order_release);
+  }
+
+  T load() const {
+    T v;
+    uint32_t s0, s1;
+    do {
+      s0 = seq_.load(std::memory_order_acquire);
+      v = data_;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      s1 = seq_.load(std::memory_order_relaxed);
+    } while ((s0 & 1) || s0 != s1);
+    return v;
+  }
+
+  // Number of completed stores.
+  uint32_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+ private:
+  std::atomic<uint32_t> seq_{0};
+  T data_{};
+};
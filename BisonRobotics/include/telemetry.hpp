@@ -0,0 +1,44 @@
+#pragma once
+// ---- Streaming serial telemetry ----
+// A 100 Hz loop takes every sensor snapshot (queued by the sensors loop in a
+// ring.hpp SPSC ring), the latest pose and the control loop timing and
+// writes them as framed binary records (wire.hpp) to the USB serial port,
+// for `telem_decode` on a laptop. With lz4_blocks, 10 ticks
+// of records go out as one LZ4-compressed BLOCK frame instead.
+// On the robot the stream takes over stdout: PROS's own stream multiplexing
+// is switched off, so printf() output would corrupt frames while it runs.
+#include <cstddef>
+#include <cstdint>
+#include "odom.hpp"
+#include "xdrive.hpp"
+
+namespace telemetry {
+
+// Pose for the POSE channel and the dashboard, from whichever task runs
+// odometry. latest_pose() is false until the first publish.
+void publish_pose(const Pose& p);
+bool latest_pose(Pose& out);
+
+// Where frames go. Default: stdout on the robot, discarded in SIM.
+using Sink = void (*)(const uint8_t* data, size_t n);
+void set_sink(Sink s);
+
+void start_stream(bool lz4_blocks = false);
+void stop_stream();
+void stream_tick();  // one tick of records (what the loop runs)
+
+// One tick of records (WHEELS, POSE once published, NAMES when `names`,
+// LOOPS) appended to out as packed {u16 len, record} entries, the BLOCK layout
+// of wire.hpp; numbered from seq. Returns the bytes written, 0 if cap is
+// below TICK_MAX. Shared by the stream and the SD logger (logger.hpp).
+constexpr size_t TICK_MAX = 4 * (2 + 8) + 16 + 12 + 16 * 24 + 1 + 16 * 8;
+size_t pack_tick(const xdrive::Snapshot& sn, uint16_t& seq, bool names, uint8_t* out, size_t cap);
+
+struct StreamStats {
+  uint32_t ticks = 0, frames = 0;
+  uint32_t dropped = 0;  // sensor samples lost while the stream fell 16 behind
+  uint64_t record_bytes = 0, wire_bytes = 0;
+};
+const StreamStats& stream_stats();
+
+} // namespace telemetry
@@ -0,0 +1,197 @@
+#pragma once
+// ---- Serial telemetry wire format ----
+// Shared by the robot (telemetry.cpp) and the host decoder (telem_decode).
+//
+// Frame on the wire:  COBS(record | crc16) 0x00
+//   record : u8 channel, u8 flags, u16 seq, u32 t_us, payload
+//   crc16  : CRC-16/CCITT-FALSE of the record, little-endian
+// COBS removes every 0x00 from the frame body, so 0x00 only ever marks a
+// frame end and a reader that joins mid-stream or drops bytes resyncs at the
+// next one. All fields are little-endian.
+//
+// Channels (payload layout):
+//   WHEELS : i16 mv[4], i16 rpm_x10[4]                       (FL, FR, BL, BR)
+//   POSE   : f32 x_in, y_in, theta_rad
+//   LOOPS  : u8 n, n x {u16 exec_us, u16 wcet_us, u16 jitter_max_us, u16 overruns}
+//   NAMES  : loop names for LOOPS, each NUL-terminated
+//   EVENT  : u8 kind, i32 a, i32 b                            (logger::Event)
+//   BLOCK  : u16 raw_len, then raw_len bytes of {u16 len, record} (flags & LZ4:
+//            the bytes are one LZ4 block, see lz4block.hpp). A BLOCK's header
+//            repeats the seq and t_us of its first record.
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "lz4block.hpp"
+
+namespace wire {
+
+enum Channel : uint8_t { WHEELS = 1, POSE = 2, LOOPS = 3, NAMES = 4, BLOCK = 5, EVENT = 6 };
+enum Flags : uint8_t { LZ4 = 1 };
+
+constexpr size_t HEADER = 8;
+constexpr size_t MAX_RECORD = 2048;                      // largest record (BLOCK)
+constexpr size_t MAX_FRAME = MAX_RECORD + 2 + MAX_RECORD / 254 + 2;  // COBS + CRC + 0x00
+
+struct Header { uint8_t channel, flags; uint16_t seq; uint32_t t_us; };
+
+inline uint16_t crc16(const uint8_t* p, size_t n, uint16_t crc = 0xFFFF) {
+  while (n--) {
+    crc ^= static_cast<uint16_t>(*p++) << 8;
+    for (int b = 0; b < 8; ++b) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// COBS-encode src into dst and append the 0x00 delimiter; returns the bytes
+// written (at most n + n / 254 + 2).
+inline size_t cobs_encode(const uint8_t* src, size_t n, uint8_t* dst) {
+  size_t code_at = 0, op = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < n; ++i) {
+    if (src[i]) { dst[op++] = src[i]; ++code; }
+    if (!src[i] || code == 0xFF) {
+      dst[code_at] = code;
+      code = 1;
+      code_at = op++;
+    }
+  }
+  dst[code_at] = code;
+  dst[op++] = 0;
+  return op;
+}
+
+// Decode one frame body (without its 0x00); returns the decoded size, or -1
+// if it is malformed or longer than cap.
+inline long cobs_decode(const uint8_t* src, size_t n, uint8_t* dst, size_t cap) {
+  size_t ip = 0, op = 0;
+  while (ip < n) {
+    const uint8_t code = src[ip++];
+    if (!code || ip + code - 1 > n) return -1;
+    for (uint8_t k = 1; k < code; ++k) {
+      if (op >= cap) return -1;
+      dst[op++] = src[ip++];
+    }
+    if (code != 0xFF && ip < n) {
+      if (op >= cap) return -1;
+      dst[op++] = 0;
+    }
+  }
+  return static_cast<long>(op);
+}
+
+// ---- Little-endian field access ----
+template <class T> inline void put(uint8_t*& p, T v) { std::memcpy(p, &v, sizeof v); p += sizeof v; }
+template <class T> inline T get(const uint8_t*& p) { T v; std::memcpy(&v, p, sizeof v); p += sizeof v; return v; }
+
+inline uint8_t* put_header(uint8_t* p, const Header& h) {
+  put(p, h.channel); put(p, h.flags); put(p, h.seq); put(p, h.t_us);
+  return p;
+}
+inline Header get_header(const uint8_t* p) {
+  Header h;
+  h.channel = get<uint8_t>(p); h.flags = get<uint8_t>(p);
+  h.seq = get<uint16_t>(p); h.t_us = get<uint32_t>(p);
+  return h;
+}
+
+// Frame a record (header + payload, `n` bytes) into out[MAX_FRAME].
+inline size_t frame(const uint8_t* record, size_t n, uint8_t* out) {
+  uint8_t body[MAX_RECORD + 2];
+  std::memcpy(body, record, n);
+  const uint16_t crc = crc16(record, n);
+  body[n] = static_cast<uint8_t>(crc);
+  body[n + 1] = static_cast<uint8_t>(crc >> 8);
+  return cobs_encode(body, n + 2, out);
+}
+
+// ---- Reader ----
+// Feed bytes as they arrive; on_record(const Header&, const uint8_t* payload,
+// size_t n) runs for every frame that decodes with a good CRC.
+struct DeframerStats { uint32_t frames = 0, bad_cobs = 0, bad_crc = 0, overflow = 0; };
+
+class Deframer {
+ public:
+  template <class F>
+  void push(const uint8_t* p, size_t n, F&& on_record) {
+    for (size_t i = 0; i < n; ++i) {
+      if (p[i]) {
+        if (len_ < sizeof buf_) buf_[len_++] = p[i];
+        else drop_ = true;
+        continue;
+      }
+      if (drop_) ++stats_.overflow;
+      else if (len_) finish(on_record);
+      len_ = 0;
+      drop_ = false;
+    }
+  }
+  const DeframerStats& stats() const { return stats_; }
+
+ private:
+  template <class F>
+  void finish(F& on_record) {
+    uint8_t rec[MAX_RECORD + 2];
+    const long n = cobs_decode(buf_, len_, rec, sizeof rec);
+    if (n < (long)HEADER + 2) { ++stats_.bad_cobs; return; }
+    const size_t m = n - 2;
+    if (crc16(rec, m) != (rec[m] | rec[m + 1] << 8)) { ++stats_.bad_crc; return; }
+    ++stats_.frames;
+    on_record(get_header(rec), rec + HEADER, m - HEADER);
+  }
+
+  uint8_t buf_[MAX_FRAME];
+  size_t len_ = 0;
+  bool drop_ = false;
+  DeframerStats stats_;
+};
+
+// Walk packed {u16 len, record} entries (a BLOCK's raw bytes) and call
+// on_record(const uint8_t* record, size_t n); false if malformed.
+template <class F>
+bool for_each_entry(const uint8_t* p, size_t n, F&& on_record) {
+  for (const uint8_t* const end = p + n; p < end;) {
+    if (p + 2 > end) return false;
+    const size_t len = get<uint16_t>(p);
+    if (len < HEADER || p + len > end) return false;
+    on_record(p, len);
+    p += len;
+  }
+  return true;
+}
+
+// Split a BLOCK payload back into its records (header + payload each) and
+// call on_record(const uint8_t* record, size_t n); false if malformed.
+template <class F>
+bool unpack_block(uint8_t flags, const uint8_t* payload, size_t n, F&& on_record) {
+  if (n < 2) return false;
+  const uint8_t* p = payload;
+  const size_t raw_len = get<uint16_t>(p);
+  uint8_t raw[MAX_RECORD];
+  if (raw_len > sizeof raw) return false;
+  if (flags & LZ4) {
+    if (lz4::decompress(p, n - 2, raw, sizeof raw) != (long)raw_len) return false;
+  } else {
+    if (n - 2 != raw_len) return false;
+    std::memcpy(raw, p, raw_len);
+  }
+  return for_each_entry(raw, raw_len, on_record);
+}
+
+// Build one BLOCK record from raw {u16 len, record} entries (1 to BLOCK_RAW
+// bytes) into rec[MAX_RECORD], LZ4-compressed when that is smaller; returns
+// the record size.
+constexpr size_t BLOCK_RAW = MAX_RECORD - HEADER - 2;
+inline size_t pack_block(const uint8_t* raw, size_t raw_len, uint8_t* rec, lz4::Table& table) {
+  const Header first = get_header(raw + 2);
+  uint8_t* p = put_header(rec, {BLOCK, LZ4, first.seq, first.t_us});
+  put(p, static_cast<uint16_t>(raw_len));
+  size_t n = lz4::compress(raw, raw_len, p, MAX_RECORD - (p - rec), table);
+  if (!n || n >= raw_len) {  // incompressible: send it raw
+    rec[1] = 0;
+    std::memcpy(p, raw, raw_len);
+    n = raw_len;
+  }
+  return (p - rec) + n;
+}
+
+} // namespace wire
@@ -3,15 +3,19 @@
 #ifdef SIM
 // --- Tiny stubs so this header compiles without PROS ---
 namespace pros {
-  enum motor_gearset_e_t { E_MOTOR_GEARSET_18 = 0 };
-  enum motor_encoder_units_e_t { E_MOTOR_ENCODER_DEGREES = 0 };
+  enum motor_gearset_e_t { E_MOTOR_GEARSET_36 = 0, E_MOTOR_GEARSET_18 = 1, E_MOTOR_GEARSET_06 = 2 };
+  enum motor_encoder_units_e_t { E_MOTOR_ENCODER_DEGREES = 0, E_MOTOR_ENCODER_ROTATIONS = 1,
+                                 E_MOTOR_ENCODER_COUNTS = 2 };
 }
 #else
 #include "api.h"
 #endif
 
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <algorithm>
+#include "profile.hpp"
 
 namespace xdrive {
 
@@ -31,22 +35,209 @@ constexpr pros::motor_encoder_units_e_t ENCODERS = pros::E_MOTOR_ENCODER_DEGREES
 
 // IMU (optional, for field-centric). Set to -1 to disable.
 constexpr int IMU_PORT = -1; // e.g., 5 to enable
+constexpr uint32_t IMU_SETTLE_MS = 100;       // is_calibrating() lags reset() by a few ms
+constexpr uint32_t IMU_CAL_TIMEOUT_MS = 5000; // imu_state() reports FAILED if not ready by then
+
+// GPS sensor (optional, absolute pose for the EKF in localize.hpp). Set its
+// mounting offset with the VEX utility. -1 to disable.
+constexpr int GPS_PORT = -1; // e.g., 6 to enable
 
 // Control options
 constexpr int  DEADBAND = 5;
 constexpr bool SQUARE_INPUTS = true;
+constexpr bool VELOCITY_CONTROL = true;  // false: open-loop move(-127..127)
+constexpr bool LVGL_DASHBOARD = true;    // brain screen: LVGL dashboard (false: llemu text)
+constexpr bool SERIAL_TELEMETRY = false; // binary stream on USB serial (telemetry.hpp); takes stdout
+constexpr bool SERIAL_LZ4 = false;       //   ...as LZ4-compressed blocks
+constexpr bool SD_LOG = true;            // log every run to the microSD card (logger.hpp)
+constexpr bool POSE_ESTIMATOR = true;    // EKF pose from wheels/IMU/GPS (localize.hpp)
+constexpr bool FOLLOW_ROUTES = false;    // autonomous() follows routes.hpp on that pose, not encoder
+                                         //   moves; wheels alone drift, so set IMU_PORT first
 
 // Init / utilities
+// initialize() only starts IMU calibration (about 2 s) and returns at once.
+// Until the IMU reports calibrated, drive(..., field_centric) maps the sticks
+// robot-centric; calibration ends at heading 0, where the two mappings agree,
+// so the switch over is seamless.
 void initialize();
-double heading_deg(); // 0..360 if IMU present, else 0
+double heading_deg(); // 0..360 CCW (same sense as Pose::theta) once calibrated, else 0
+
+enum class ImuState { NONE, CALIBRATING, READY, FAILED };  // FAILED: not ready by the timeout
+ImuState imu_state();
+const char* imu_label();  // status line for the screen, "" when nothing to report
+
+// ---- Sensor snapshots ----
+// The "sensors" loop reads every drive device once per 10 ms tick and
+// publishes the readings through a Seqlock; drive(), the helpers,
+// heading_deg() and telemetry all read the latest snapshot instead of
+// calling into the device layer themselves. The loop runs above every
+// reader's priority, so a reader never spins on a half-written snapshot.
+// Until start_sensors() (host tools that never start it), sensors()
+// reads the devices directly on each call.
+struct Snapshot {
+  uint64_t t_us;            // pros::micros() when sampled
+  uint32_t seq;             // increments every sample
+  double pos_deg[4];        // FL, FR, BL, BR wheel position
+  double rpm[4];            // actual velocity
+  double mv[4];             // applied voltage
+  double imu_heading_deg;   // raw IMU heading (PROS: 0..360 CW)
+  double imu_rate_dps;      // IMU yaw rate, + = CW like the heading (0 in SIM)
+  bool imu_ready;           // IMU configured and not calibrating
+  double gps_x_m, gps_y_m;  // GPS position (PROS: meters from field centre)
+  double gps_heading_deg;   // GPS heading (0..360 CW from north)
+  double gps_error_m;       // GPS get_error(), its RMS position error
+  bool gps_ready;           // GPS configured and reporting
+};
+Snapshot sensors();
+double heading_deg(const Snapshot& sn);  // heading_deg() as of `sn`
+void start_sensors();
+void stop_sensors();
+bool sensors_running();
+// Called in the sensors loop with each new snapshot (serial stream, SD
+// logger; up to 4). Runs at the loop's priority: it must be short and never
+// block, e.g. push into a ring.hpp ring. False if all slots are taken.
+using SampleHook = void (*)(const Snapshot& s);
+bool add_sample_hook(SampleHook fn);
+void remove_sample_hook(SampleHook fn);
+#ifdef SIM
+void sim_set_heading(double deg);  // what the IMU mock reports (host tools)
+void sim_set_imu_calibration_ms(uint32_t ms);  // mock calibration time from the next initialize() (0)
+#endif
+
+// Input shaping / mixing used by drive() (inline so the benchmarks and the
+// log replay tool run exactly the same math)
+inline int deadband(int v, int db = DEADBAND) { return (std::abs(v) < db) ? 0 : v; }
+inline double signed_square(int v) {
+  const double s = v / 127.0;
+  return std::copysign(s * s, s) * 127.0;
+}
+// Normalize 4 wheel values to [-127..127]
+inline void normalize(double &fl, double &fr, double &bl, double &br) {
+  const double maxmag = std::max({std::abs(fl), std::abs(fr), std::abs(bl), std::abs(br), 127.0});
+  if (maxmag > 127.0) {
+    const double k = 127.0 / maxmag;
+    fl *= k; fr *= k; bl *= k; br *= k;
+  }
+}
+
+// Stick shaping options; drive() uses the defaults above.
+struct Shaping { int deadband = DEADBAND; bool square = SQUARE_INPUTS; };
+inline double shape(int v, const Shaping& sh = {}) {
+  v = deadband(v, sh.deadband);
+  return sh.square ? signed_square(v) : v;
+}
+
+// Joystick value that shape() maps to (about) v, for code that drives through
+// drive() with computed commands. Below the deadband the result is 0.
+inline int unshape(double v, const Shaping& sh = {}) {
+  v = std::max(-127.0, std::min(127.0, v));
+  const double j = sh.square ? std::copysign(std::sqrt(std::abs(v) / 127.0) * 127.0, v) : v;
+  const int k = static_cast<int>(std::lround(j));
+  return std::abs(k) < sh.deadband ? 0 : k;
+}
+
+// X-drive kinematics: +df=forward, +ds=right, +dr=CW, normalized
+struct WheelMix { double fl, fr, bl, br; };
+inline WheelMix mix(double df, double ds, double dr) {
+  WheelMix w{df + ds + dr, df - ds - dr, df - ds + dr, df + ds - dr};
+  normalize(w.fl, w.fr, w.bl, w.br);
+  return w;
+}
+
+// Teleop drive (joystick units -127..127)  +fwd, +right, +CW. `sh` lets
+// the log replay tool (sim_replay) try other stick shaping on the same path.
+void drive(int fwd, int str, int rot, bool field_centric = false, const Shaping& sh = {});
+
+// Output speed of the configured cartridge (rpm)
+constexpr double gear_rpm() {
+  return GEARSET == pros::E_MOTOR_GEARSET_36 ? 100.0 : GEARSET == pros::E_MOTOR_GEARSET_06 ? 600.0 : 200.0;
+}
+
+// Wheel velocity loop used by drive() when VELOCITY_CONTROL is set. Wheel
+// targets (-127..127 after mixing) become rpm of the cartridge's free speed,
+// and each wheel gets move_voltage() of
+//   volts = kS*sign(v) + kV*v + kA*a + kP*(v - measured)
+// v in rpm, a in rpm/s (change of target since the last call). Defaults fit
+// the SIM motor model with a 4" wheel; re-fit kS/kV/kA on the robot.
+struct VelGains {
+  double kS = 0.47;     // V, breakaway
+  double kV = 0.061;    // V per rpm
+  double kA = 0.0046;   // V per rpm/s
+  double kP = 0.02;     // V per rpm of error
+};
+void set_velocity_gains(const VelGains& g);
+const VelGains& velocity_gains();
+
+// Wheel position loop for the helpers, run at 100 Hz on every wheel. The
+// setpoint follows a motion profile (see MotionLimits) from 0 to the target:
+//   volts = VelGains feedforward(v_sp, a_sp)
+//         + kP*err + kI*integral(err) + kD*(v_sp - velocity) + kS*sign(err)
+// err = p_sp - position in wheel degrees, velocities in deg/s. kS (static
+// friction feedforward) is only added once the profile has ended, until the
+// wheel is within tol_deg. Defaults come from sim_tune.
+struct PosGains {
+  double   kP = 0.85, kI = 2.5e-5, kD = 0.03, kS = 0.03;
+  double   tol_deg    = 3.0;   // settled when every wheel is within this...
+  uint32_t settle_ms  = 60;    // ...for this long
+  uint32_t timeout_ms = 4000;  // give up (result.settled == false)
+};
+void set_position_gains(const PosGains& g);
+const PosGains& position_gains();
+
+// Per-axis profile limits for the helpers, in wheel degrees (profile.hpp).
+// The helpers' `speed` (rpm) further caps v. jerk == 0 gives trapezoids.
+enum class Axis { Forward, Strafe, Rotate };
+struct MotionLimits {
+  profile::Limits forward{1200.0, 4800.0, 48000.0};
+  profile::Limits strafe {1200.0, 3600.0, 36000.0};  // rollers slip sooner sideways
+  profile::Limits rotate {1200.0, 4800.0, 48000.0};
+  const profile::Limits& operator[](Axis a) const {
+    return a == Axis::Forward ? forward : a == Axis::Strafe ? strafe : rotate;
+  }
+};
+void set_motion_limits(const MotionLimits& l);
+const MotionLimits& motion_limits();
+
+struct MoveResult {
+  uint32_t ms;            // until settled or timed out
+  double overshoot_deg;   // worst wheel travel past its target
+  double error_deg;       // worst wheel error when the move ended
+  bool settled;
+};
+
+// Simple blocking helpers (run on the motor model in SIM)
+MoveResult drive_forward_deg(double wheel_deg, int speed = 100);
+MoveResult strafe_right_deg(double wheel_deg, int speed = 100);
+MoveResult turn_cw_deg(double wheel_deg, int speed = 100);
+
+// ---- Non-blocking motions ----
+// The *_async helpers hand the same move to a motion task and return at once,
+// so the caller can run mechanisms or sensing while the chassis drives. One
+// motion runs at a time: starting another cancels the current one, and
+// drive() must not be called until it is done. The motion task wakes a task
+// blocked in wait() with pros::Task::notify() instead of it polling; up to
+// four tasks can wait at once (a fifth wait() returns false at once).
+class Motion {
+ public:
+  Motion() = default;           // refers to no motion (done, not settled)
+  explicit Motion(uint32_t id): id_(id) {}
+
+  bool done() const;
+  MoveResult result() const;    // all zero and !settled until done()
+  bool wait(uint32_t timeout_ms = UINT32_MAX);  // true once done
+  void cancel();                // stops the wheels; result().settled == false
 
-// Teleop drive (joystick units -127..127)  +fwd, +right, +CW
-void drive(int fwd, int str, int rot, bool field_centric = false);
+ private:
+  uint32_t id_ = 0;
+};
 
-// Simple blocking helpers (no-ops in SIM)
-void drive_forward_deg(double wheel_deg, int speed = 100);
-void strafe_right_deg(double wheel_deg, int speed = 100);
-void turn_cw_deg(double wheel_deg, int speed = 100);
+Motion drive_forward_async(double wheel_deg, int speed = 100);
+Motion strafe_right_async(double wheel_deg, int speed = 100);
+Motion turn_cw_async(double wheel_deg, int speed = 100);
+// Cancel whatever motion is running (the motion task outlives autonomous()).
+// For mode changes: it forgets tasks blocked in wait() without waking them,
+// since the framework may have deleted them. Use Motion::cancel() elsewhere.
+void stop_motion();
 
 // Convenience
 inline double inches_to_deg(double inches, double wheel_diam_in = 4.0) {
@@ -54,7 +245,8 @@ inline double inches_to_deg(double inches, double wheel_diam_in = 4.0) {
   return (inches / circ) * 360.0;
 }
 
-// LCD telemetry (does nothing in SIM)
+// Screen telemetry: the LVGL dashboard (dashboard.hpp) on the robot when
+// LVGL_DASHBOARD is set, else llemu text (sim::lcd_line() in SIM)
 void start_telemetry();
 void stop_telemetry();
 
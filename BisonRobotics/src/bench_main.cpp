@@ -0,0 +1,92 @@
+#ifdef SIM
+// Host microbenchmarks for the drive and odometry hot paths (`make bench`).
+// Build: g++ -DSIM -O2 -std=gnu++17 -Iinclude -o bench
+//          src/bench_main.cpp src/xdrive.cpp src/control.cpp src/sim_pros.cpp
+// Usage: bench [--json out.json] [--compare base.json] [--tolerance f] [--quick]
+//   --compare exits 1 if any p50 is more than `tolerance` (default 0.15)
+//   slower than the same benchmark in base.json.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "sim_compat.hpp"
+#include "bench_suite.hpp"
+
+// Read {"name": ..., "p50": ...} pairs back from a write_json() file.
+static std::vector<std::pair<std::string, double>> load_p50(const char* path) {
+  std::vector<std::pair<std::string, double>> out;
+  std::FILE* f = std::fopen(path, "r");
+  if (!f) return out;
+  char line[512];
+  while (std::fgets(line, sizeof line, f)) {
+    const char* n = std::strstr(line, "\"name\": \"");
+    const char* p = std::strstr(line, "\"p50\": ");
+    if (!n || !p) continue;
+    n += 9;
+    const char* e = std::strchr(n, '"');
+    if (e) out.emplace_back(std::string(n, e), std::atof(p + 7));
+  }
+  std::fclose(f);
+  return out;
+}
+
+static int compare(const std::vector<bench::Result>& rs, const char* base_path, double tol) {
+  const auto base = load_p50(base_path);
+  if (base.empty()) { std::fprintf(stderr, "%s: no benchmarks to compare\n", base_path); return 2; }
+  int regressions = 0;
+  std::printf("\n%-24s %9s %9s %8s\n", "vs baseline (p50)", "base", "now", "delta");
+  for (const bench::Result& r : rs) {
+    for (const auto& b : base) {
+      if (b.first != r.name || b.second <= 0.0) continue;
+      const double d = r.p50 / b.second - 1.0;
+      const bool bad = d > tol;
+      regressions += bad;
+      std::printf("%-24s %9.2f %9.2f %+7.1f%%%s\n", r.name, b.second, r.p50, d * 100.0,
+                  bad ? "  REGRESSION" : "");
+    }
+  }
+  return regressions ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+  const char* json = nullptr;
+  const char* base = nullptr;
+  double tol = 0.15;
+  bench::Options opt;
+
+  for (int i = 1; i < argc; ++i) {
+    auto arg = [&](const char* name){ return !std::strcmp(argv[i], name) && i + 1 < argc; };
+    if      (arg("--json"))      json = argv[++i];
+    else if (arg("--compare"))   base = argv[++i];
+    else if (arg("--tolerance")) tol  = std::atof(argv[++i]);
+    else if (!std::strcmp(argv[i], "--quick")) { opt.warmup = 5; opt.samples = 50; }
+    else { std::fprintf(stderr, "unknown argument: %s\n", argv[i]); return 2; }
+  }
+
+  // drive() writes to the motor mocks; keep the virtual clock still so they
+  // never integrate and only the code under test is timed.
+  sim::set_clock_mode(sim::ClockMode::Fast);
+  xdrive::initialize();
+
+  auto now = []{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  };
+  bench::Runner<decltype(now)> runner(now, opt);
+  bench::run_suite(runner, false);
+
+  bench::print_table(stdout, runner.results());
+  std::printf("control_tick p99 = %.4f%% of the 10 ms tick\n",
+              bench::tick_budget_pct(runner.results()));
+
+  if (json) {
+    std::FILE* f = std::fopen(json, "w");
+    if (!f) { std::perror(json); return 1; }
+    bench::write_json(f, "host", runner.results());
+    std::fclose(f);
+  }
+  return base ? compare(runner.results(), base, tol) : 0;
+}
+#endif
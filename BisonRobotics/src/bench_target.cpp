@@ -0,0 +1,25 @@
+#if defined(BENCH) && !defined(SIM)
+// On-brain microbenchmarks, same suite as the host `bench` tool.
+// Build with `make BENCH=1`; initialize() then runs the suite once and prints
+// the table and JSON to the terminal (`pros terminal`), with the sticks held
+// centered so the drive motors only receive zero commands.
+#include "main.h"
+#include "bench_suite.hpp"
+
+void bench::run_on_target() {
+  Options opt;
+  opt.warmup = 5;
+  opt.samples = 50;
+  opt.min_sample_ns = 2000000;  // 2 ms per sample against 1 us micros()
+
+  auto now = []{ return (uint64_t)pros::micros() * 1000u; };
+  Runner<decltype(now)> runner(now, opt);
+  run_suite(runner, true);
+
+  print_table(stdout, runner.results());
+  std::printf("control_tick p99 = %.2f%% of the 10 ms tick\n", tick_budget_pct(runner.results()));
+  write_json(stdout, "v5", runner.results());
+  std::fflush(stdout);
+  pros::lcd::print(6, "bench: tick p99 %.2f%%", tick_budget_pct(runner.results()));
+}
+#endif
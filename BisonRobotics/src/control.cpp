@@ -0,0 +1,77 @@
+#include "sim_compat.hpp"
+#include "control.hpp"
+
+namespace control {
+
+struct Registry { Loop* loops[MAX_LOOPS]; size_t n = 0; };
+
+// Function-local so Loops defined at namespace scope in other files can
+// register during static initialization.
+static Registry& registry() { static Registry r; return r; }
+
+Loop::Loop(const char* name, uint32_t period_ms, uint32_t priority, std::function<void()> fn)
+    : name_(name), period_(period_ms ? period_ms : 1), prio_(priority), fn_(std::move(fn)) {
+  Registry& r = registry();
+  if (r.n < MAX_LOOPS) r.loops[r.n++] = this;
+}
+
+size_t loop_count() { return registry().n; }
+const Loop& loop(size_t i) { return *registry().loops[i]; }
+
+void Loop::run() {
+  pros::Task::current().set_priority(prio_);
+  const uint32_t gen = gen_ + 1;  // a later run()/stop() retires this one
+  gen_ = gen;
+  running_ = true;
+  uint32_t release = pros::millis();
+  while (gen == gen_) {
+    const uint64_t start = pros::micros();
+    fn_();
+    const uint64_t end = pros::micros();
+
+    const uint64_t rel_us = (uint64_t)release * 1000;
+    const uint32_t late = start > rel_us ? (uint32_t)(start - rel_us) : 0;
+    const uint32_t exec = (uint32_t)(end - start);
+    ++stats_.runs;
+    stats_.exec_last_us = exec;
+    if (exec > stats_.wcet_us) stats_.wcet_us = exec;
+    if (late > stats_.jitter_max_us) stats_.jitter_max_us = late;
+    stats_.jitter_sum_us += late;
+    if (end > rel_us + (uint64_t)period_ * 1000) ++stats_.overruns;
+
+    // More than a whole period behind: drop the missed releases and run the
+    // next one late, instead of letting delay_until() fire them back to back.
+    const uint32_t now = pros::millis();
+    if (now - release >= 2 * period_) {
+      const uint32_t k = (now - release) / period_ - 1;
+      release += k * period_;
+      stats_.skipped += k;
+    }
+    pros::Task::delay_until(&release, period_);
+  }
+}
+
+void Loop::start() {
+  if (running_) return;
+  running_ = true;
+  pros::Task([this]{ run(); }, prio_, TASK_STACK_DEPTH_DEFAULT, name_);
+}
+
+// The loop task notices at its next release and returns. It is never removed
+// from outside, since it could be holding a PROS mutex (LCD, serial).
+void Loop::stop() {
+  gen_ = gen_ + 1;
+  running_ = false;
+}
+
+#ifdef SIM
+// sim::kill_all_tasks() deletes loop tasks without stop(): retire them all,
+// so running() reads false and start() makes a new task.
+static void retire_all() {
+  Registry& r = registry();
+  for (size_t i = 0; i < r.n; ++i) r.loops[i]->stop();
+}
+[[maybe_unused]] static const bool retire_hooked = (sim::on_kill_all_tasks(retire_all), true);
+#endif
+
+} // namespace control
@@ -0,0 +1,168 @@
+#ifndef SIM
+#include <cmath>
+#include <cstdio>
+#include "main.h"
+#include "liblvgl/lvgl.h"
+#include "dashboard.hpp"
+#include "xdrive.hpp"
+#include "control.hpp"
+#include "telemetry.hpp"
+
+namespace dashboard {
+
+// Redraw thresholds
+constexpr int    BAR_PCT     = 2;     // wheel voltage bars (% of 12 V)
+constexpr double RPM         = 2.0;   // rpm readouts
+constexpr double POSE_IN     = 0.1;   // pose x, y
+constexpr double POSE_DEG    = 0.5;   // pose heading
+constexpr int    TRACE_EVERY = 3;     // ticks per chart point (10 Hz)
+constexpr int    STATS_EVERY = 30;    // ticks per loop-timing refresh (1 Hz)
+constexpr int    TRACE_POINTS = 100;  // 10 s of trace
+
+static const char* const WHEEL[4] = {"FL", "FR", "BL", "BR"};
+
+struct Ui {
+  lv_obj_t* screen = nullptr;
+  lv_obj_t* bar[4];
+  lv_obj_t* rpm[4];
+  lv_obj_t* chart;
+  lv_chart_series_t* trace[4];
+  lv_obj_t* pose;
+  lv_obj_t* stats;
+  // Last values written to each widget
+  int shown_pct[4];
+  double shown_rpm[4];
+  Pose shown_pose;
+  bool pose_valid;
+  bool trace_flat;
+  int tick;
+};
+static Ui ui;
+
+static void build() {
+  static const lv_palette_t color[4] = {LV_PALETTE_RED, LV_PALETTE_BLUE, LV_PALETTE_GREEN,
+                                        LV_PALETTE_AMBER};
+  ui.screen = lv_obj_create(nullptr);
+  lv_obj_set_style_bg_color(ui.screen, lv_color_black(), 0);
+  lv_obj_set_style_text_color(ui.screen, lv_color_white(), 0);
+
+  // Left column: one row per wheel (name, symmetric bar, rpm)
+  for (int k = 0; k < 4; ++k) {
+    const int y = 8 + 30 * k;
+    lv_obj_t* name = lv_label_create(ui.screen);
+    lv_label_set_text_static(name, WHEEL[k]);
+    lv_obj_set_pos(name, 6, y);
+
+    ui.bar[k] = lv_bar_create(ui.screen);
+    lv_bar_set_mode(ui.bar[k], LV_BAR_MODE_SYMMETRICAL);
+    lv_bar_set_range(ui.bar[k], -100, 100);
+    lv_obj_set_size(ui.bar[k], 120, 14);
+    lv_obj_set_pos(ui.bar[k], 36, y + 3);
+    lv_obj_set_style_bg_color(ui.bar[k], lv_palette_main(color[k]), LV_PART_INDICATOR);
+
+    ui.rpm[k] = lv_label_create(ui.screen);
+    lv_obj_set_pos(ui.rpm[k], 164, y);
+    ui.shown_pct[k] = INT32_MIN;
+    ui.shown_rpm[k] = 1e9;
+  }
+
+  ui.pose = lv_label_create(ui.screen);
+  lv_obj_set_pos(ui.pose, 6, 130);
+  lv_label_set_text_static(ui.pose, "pose: --");
+  ui.pose_valid = false;
+
+  ui.stats = lv_label_create(ui.screen);
+  lv_obj_set_pos(ui.stats, 6, 156);
+  lv_label_set_text_static(ui.stats, "");
+
+  // Right: velocity traces. Circular mode only invalidates around the new
+  // point instead of scrolling (and redrawing) the whole plot.
+  ui.chart = lv_chart_create(ui.screen);
+  lv_obj_set_size(ui.chart, 240, 220);
+  lv_obj_set_pos(ui.chart, 232, 10);
+  lv_chart_set_type(ui.chart, LV_CHART_TYPE_LINE);
+  lv_chart_set_update_mode(ui.chart, LV_CHART_UPDATE_MODE_CIRCULAR);
+  lv_chart_set_point_count(ui.chart, TRACE_POINTS);
+  const int32_t rpm_max = static_cast<int32_t>(xdrive::gear_rpm());
+  lv_chart_set_range(ui.chart, LV_CHART_AXIS_PRIMARY_Y, -rpm_max, rpm_max);
+  lv_obj_set_style_size(ui.chart, 0, 0, LV_PART_INDICATOR);  // no point markers
+  for (int k = 0; k < 4; ++k) {
+    ui.trace[k] = lv_chart_add_series(ui.chart, lv_palette_main(color[k]), LV_CHART_AXIS_PRIMARY_Y);
+    lv_chart_set_all_value(ui.chart, ui.trace[k], 0);
+  }
+
+  ui.trace_flat = true;
+  ui.tick = 0;
+  lv_screen_load(ui.screen);
+}
+
+static void refresh_stats() {
+  // IMU label plus one line per loop: name, three 10-digit counters, ~60 chars
+  static char buf[32 + control::MAX_LOOPS * 64];
+  const char* imu = xdrive::imu_label();
+  int n = *imu ? std::snprintf(buf, sizeof buf, "%s\n", imu) : 0;
+  for (size_t i = 0; i < control::loop_count() && n < (int)sizeof buf; ++i) {
+    const control::Loop& l = control::loop(i);
+    const control::Stats& st = l.stats();
+    n += std::snprintf(buf + n, sizeof buf - n, "%-9s ovr %u wcet %u jit %u us\n", l.name(),
+                       (unsigned)st.overruns, (unsigned)st.wcet_us, (unsigned)st.jitter_max_us);
+  }
+  lv_label_set_text(ui.stats, buf);
+}
+
+static void tick() {
+  const xdrive::Snapshot sn = xdrive::sensors();
+
+  for (int k = 0; k < 4; ++k) {
+    const int pct = static_cast<int>(std::lround(std::max(-100.0, std::min(100.0, sn.mv[k] / 120.0))));
+    if (std::abs(pct - ui.shown_pct[k]) >= BAR_PCT || (pct == 0 && ui.shown_pct[k] != 0)) {
+      lv_bar_set_value(ui.bar[k], pct, LV_ANIM_OFF);
+      ui.shown_pct[k] = pct;
+    }
+    if (std::abs(sn.rpm[k] - ui.shown_rpm[k]) >= RPM) {
+      lv_label_set_text_fmt(ui.rpm[k], "%4d rpm", static_cast<int>(std::lround(sn.rpm[k])));
+      ui.shown_rpm[k] = sn.rpm[k];
+    }
+  }
+
+  // Traces: a point per wheel at 10 Hz. While the chassis sits still the
+  // trace pauses after one flat point, so an idle robot redraws nothing.
+  if (ui.tick % TRACE_EVERY == 0) {
+    bool still = true;
+    for (int k = 0; k < 4; ++k) still = still && std::abs(sn.rpm[k]) < RPM;
+    if (!still || !ui.trace_flat) {
+      for (int k = 0; k < 4; ++k)
+        lv_chart_set_next_value(ui.chart, ui.trace[k], static_cast<int32_t>(std::lround(sn.rpm[k])));
+      ui.trace_flat = still;
+    }
+  }
+
+  Pose p;
+  if (telemetry::latest_pose(p)) {
+    const double dth_deg = std::abs(Odom2WIMU::wrap(p.theta - ui.shown_pose.theta)) * 180.0 / M_PI;
+    if (!ui.pose_valid || std::hypot(p.x - ui.shown_pose.x, p.y - ui.shown_pose.y) >= POSE_IN ||
+        dth_deg >= POSE_DEG) {
+      lv_label_set_text_fmt(ui.pose, "pose: x %6.1f  y %6.1f in  th %6.1f deg", p.x, p.y,
+                            p.theta * 180.0 / M_PI);
+      ui.shown_pose = p;
+      ui.pose_valid = true;
+    }
+  }
+
+  if (ui.tick % STATS_EVERY == 0) refresh_stats();
+  ++ui.tick;
+}
+
+// 30 Hz, below the control loops
+static control::Loop loop("dashboard", 33, TASK_PRIORITY_DEFAULT - 2, tick);
+
+void start() {
+  if (!ui.screen) build();
+  else lv_screen_load(ui.screen);
+  loop.start();
+}
+
+void stop() { loop.stop(); }
+
+} // namespace dashboard
+#endif
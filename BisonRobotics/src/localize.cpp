@@ -0,0 +1,118 @@
+#ifdef SIM
+#include "sim_compat.hpp"
+#else
+#include "main.h"
+#endif
+#include <cmath>
+#include "localize.hpp"
+#include "control.hpp"
+#include "ekf.hpp"
+#include "ring.hpp"
+#include "telemetry.hpp"
+#include "xdrive.hpp"
+
+namespace localize {
+
+constexpr double WHEEL_DIAM_IN = 4.0;
+// 45-degree rollers: the chassis moves sqrt(2) times the wheel's own travel.
+constexpr double IN_PER_WHEEL_DEG = WHEEL_DIAM_IN * M_PI / 360.0 * M_SQRT2;
+constexpr double IN_PER_M = 39.37007874;
+// Chassis centre to a wheel's contact patch (measure it). Turning in place
+// rolls each wheel R * w; in the sqrt(2)-scaled travel above that reads as
+// sqrt(2) * R * w.
+constexpr double WHEEL_R_IN = 9.0;
+constexpr double TURN_LEVER_IN = WHEEL_R_IN * M_SQRT2;
+
+// Drive encoders slip far more than an unpowered tracking wheel.
+static ekf::Noise drive_noise() {
+  ekf::Noise n;
+  n.wheel_frac = 0.15;
+  n.wheel_ips = 1.0;
+  return n;
+}
+
+struct State {
+  ekf::Noise noise = drive_noise();
+  ekf::Ekf filt{OdomConfig{0.0, 0.0}, noise};
+  double heading0 = 0.0;        // added to the IMU heading (start.theta without a GPS)
+  xdrive::Snapshot last{};
+  bool primed = false;
+  double last_gps[3] = {};      // the GPS repeats a fix until its next one
+  Stats stats;
+};
+static State lc;
+
+static ring::SpscRing<xdrive::Snapshot, 16> samples;
+
+static void on_sample(const xdrive::Snapshot& s) {
+  if (!samples.push(s)) ++lc.stats.dropped;
+}
+
+static void update(const xdrive::Snapshot& sn) {
+  if (!lc.primed) { lc.last = sn; lc.primed = true; return; }
+  const double dt = (sn.t_us - lc.last.t_us) * 1e-6;
+  double d[4];
+  for (int k = 0; k < 4; ++k) d[k] = (sn.pos_deg[k] - lc.last.pos_deg[k]) * IN_PER_WHEEL_DEG;
+  lc.last = sn;
+  if (dt <= 0.0) return;
+
+  // Inverse of xdrive::mix(): forward and right travel, and the CW turn, which
+  // keeps a heading without the IMU (and while it calibrates) but slips as
+  // much as the rest; the gyro and heading outweigh it once ready.
+  const ekf::Noise& n = lc.noise;
+  lc.filt.update_wheels((d[0] + d[1] + d[2] + d[3]) / 4.0, (d[0] - d[1] - d[2] + d[3]) / 4.0, dt);
+  const double turn = (d[0] - d[1] + d[2] - d[3]) / 4.0 / dt;
+  lc.filt.update_turn(-turn / TURN_LEVER_IN, (n.wheel_frac * std::abs(turn) + n.wheel_ips) / TURN_LEVER_IN);
+  if (sn.imu_ready) lc.filt.update_gyro(-sn.imu_rate_dps * M_PI / 180.0);  // PROS turns CW
+  lc.filt.predict(dt);
+  if (sn.imu_ready)
+    lc.filt.update_heading(Odom2WIMU::wrap(lc.heading0 - sn.imu_heading_deg * M_PI / 180.0));
+
+  const double fix[3] = {sn.gps_x_m, sn.gps_y_m, sn.gps_heading_deg};
+  if (sn.gps_ready && (fix[0] != lc.last_gps[0] || fix[1] != lc.last_gps[1] || fix[2] != lc.last_gps[2])) {
+    for (int k = 0; k < 3; ++k) lc.last_gps[k] = fix[k];
+    if (lc.filt.update_gps(ekf::gps_pose(fix[0], fix[1], fix[2]), sn.gps_error_m * IN_PER_M))
+      ++lc.stats.gps_fixes;
+    else
+      ++lc.stats.gps_rejected;
+  }
+
+  ++lc.stats.ticks;
+  telemetry::publish_pose(lc.filt.pose());
+}
+
+static void tick() {
+  xdrive::Snapshot sn;
+  while (samples.pop(sn)) update(sn);
+}
+
+// Below sensors and drive, above the serial stream, so each tick's pose is
+// out before the stream packs it.
+static control::Loop loop("pose", 10, TASK_PRIORITY_DEFAULT, tick);
+
+void start(const Pose& start) {
+  if (loop.running()) return;
+  ekf::Prior pr;
+  lc.heading0 = start.theta;
+  if (xdrive::GPS_PORT > 0) {  // anywhere on the field, any heading
+    pr.xy = 72.0;
+    pr.th = pr.dh = M_PI;
+    lc.heading0 = 0.0;
+  }
+  lc.filt.reset(start, pr);
+  lc.primed = false;
+  lc.stats = Stats{};
+  samples.clear();
+  xdrive::add_sample_hook(on_sample);
+  loop.start();
+}
+
+void stop() {
+  loop.stop();
+  xdrive::remove_sample_hook(on_sample);
+}
+
+bool running() { return loop.running(); }
+const Stats& stats() { return lc.stats; }
+
+} // namespace localize
@@ -0,0 +1,290 @@
+#ifdef SIM
+#include "sim_compat.hpp"
+#else
+#include "main.h"
+#endif
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include "logger.hpp"
+#include "lz4block.hpp"
+#include "ring.hpp"
+#include "telemetry.hpp"
+#include "wire.hpp"
+
+namespace logger {
+
+constexpr int NAMES_EVERY = 100;  // ticks between loop-name records
+
+// Frames one buffer can turn into: chunks end on record boundaries, so each
+// holds at least BLOCK_RAW - TICK_MAX bytes.
+constexpr size_t OUT_BYTES =
+    (BUFFER_BYTES / (wire::BLOCK_RAW - telemetry::TICK_MAX) + 2) * wire::MAX_FRAME;
+
+struct PendingEvent { uint32_t t_us; Event kind; int32_t a, b; };
+constexpr size_t EVENT_ENTRY = 2 + wire::HEADER + 9;
+
+struct Buffer {
+  uint8_t data[BUFFER_BYTES];
+  size_t len = 0;
+  bool sync = false;               // fflush() once written (flush())
+  std::atomic<bool> full{false};   // owned by the writer while set
+};
+
+struct State {
+  // Producer side (sensors loop)
+  Buffer buf[2];
+  int active = 0;
+  uint16_t seq = 0;
+  std::atomic<bool> flush_req{false};
+  std::atomic<bool> sync_req{false};  // fflush() with nothing buffered
+  ring::MpscRing<PendingEvent, 32> events;
+  std::atomic<uint32_t> dropped_events{0};  // counted by the posting tasks
+  // Writer side
+  int next = 0;
+  std::FILE* cur = nullptr;
+  std::FILE* ahead = nullptr;      // next slot, opened early
+  unsigned slot = 0;
+  uint32_t cur_bytes = 0;
+  char dir[48] = "";
+  char path[64] = "";
+  uint8_t out[OUT_BYTES];
+  uint8_t rec[wire::MAX_RECORD];
+  lz4::Table table;
+  pros::task_t writer = nullptr;
+  std::atomic<bool> stopping{false}, writer_done{false};
+  bool running = false;
+  Stats stats;
+};
+static State lg;
+
+// ---- Files ----
+static void slot_path(unsigned slot, char* path, size_t n) {
+  std::snprintf(path, n, "%sbrlog_%02u.bin", lg.dir, slot);
+}
+
+static std::FILE* open_slot(unsigned slot) {
+  char path[64];
+  slot_path(slot, path, sizeof path);
+  return std::fopen(path, "wb");
+}
+
+static unsigned last_slot() {
+  char path[64];
+  std::snprintf(path, sizeof path, "%sbrlog.idx", lg.dir);
+  unsigned slot = LOG_FILES - 1;
+  if (std::FILE* f = std::fopen(path, "r")) {
+    if (std::fscanf(f, "%u", &slot) != 1 || slot >= LOG_FILES) slot = LOG_FILES - 1;
+    std::fclose(f);
+  }
+  return slot;
+}
+
+static void save_slot(unsigned slot) {
+  char path[64];
+  std::snprintf(path, sizeof path, "%sbrlog.idx", lg.dir);
+  if (std::FILE* f = std::fopen(path, "w")) {
+    std::fprintf(f, "%u\n", slot);
+    std::fclose(f);
+  }
+}
+
+// Past 3/4 of the current file, open the next slot; at the limit, swap to it.
+static void rotate_if_needed() {
+  if (!lg.ahead && lg.cur_bytes >= MAX_FILE_BYTES / 4 * 3)
+    lg.ahead = open_slot((lg.slot + 1) % LOG_FILES);
+  if (lg.cur_bytes < MAX_FILE_BYTES || !lg.ahead) return;
+  std::fclose(lg.cur);
+  lg.cur = lg.ahead;
+  lg.ahead = nullptr;
+  lg.slot = (lg.slot + 1) % LOG_FILES;
+  lg.cur_bytes = 0;
+  ++lg.stats.files;
+  save_slot(lg.slot);
+  slot_path(lg.slot, lg.path, sizeof lg.path);
+}
+
+// ---- Writer task ----
+// One full buffer: BLOCK frames of up to BLOCK_RAW raw bytes each, cut on
+// record boundaries, then one fwrite().
+static void write_buffer(Buffer& b) {
+  size_t n_out = 0;
+  for (size_t pos = 0; pos < b.len;) {
+    size_t end = pos;
+    while (end < b.len) {
+      uint16_t len;
+      std::memcpy(&len, b.data + end, 2);
+      if (end != pos && end + 2 + len - pos > wire::BLOCK_RAW) break;
+      end += 2 + len;
+    }
+    const size_t m = wire::pack_block(b.data + pos, end - pos, lg.rec, lg.table);
+    n_out += wire::frame(lg.rec, m, lg.out + n_out);
+    ++lg.stats.blocks;
+    pos = end;
+  }
+
+  const uint64_t t0 = pros::micros();
+  if (std::fwrite(lg.out, 1, n_out, lg.cur) != n_out) ++lg.stats.write_errors;
+  if (b.sync) std::fflush(lg.cur);
+  const uint32_t dt = static_cast<uint32_t>(pros::micros() - t0);
+  if (dt > lg.stats.write_max_us) lg.stats.write_max_us = dt;
+  lg.stats.file_bytes += n_out;
+  lg.cur_bytes += n_out;
+  rotate_if_needed();
+}
+
+// Created by the first start() and kept; idle while the logger is stopped.
+static void writer_main() {
+  while (true) {
+    pros::Task::notify_take(true, 100);
+    if (!lg.cur) continue;
+    const bool last = lg.stopping;  // read before draining: nothing arrives after it
+    while (lg.buf[lg.next].full) {
+      Buffer& b = lg.buf[lg.next];
+      write_buffer(b);
+      b.len = 0;
+      b.sync = false;
+      b.full = false;
+      lg.next ^= 1;
+    }
+    if (lg.sync_req.exchange(false)) std::fflush(lg.cur);
+    if (!last) continue;
+    std::fclose(lg.cur);
+    if (lg.ahead) std::fclose(lg.ahead);
+    lg.cur = lg.ahead = nullptr;
+    lg.writer_done = true;
+  }
+}
+
+// ---- Producer (sensors loop) ----
+// Hand the active buffer to the writer and switch to the other one; false
+// if the writer still has it.
+static bool hand_off(bool sync) {
+  Buffer& other = lg.buf[lg.active ^ 1];
+  if (other.full) return false;
+  Buffer& b = lg.buf[lg.active];
+  b.sync = sync;
+  b.full = true;
+  ++lg.stats.buffers;
+  lg.active ^= 1;
+  pros::Task(lg.writer).notify();
+  return true;
+}
+
+static void record(const xdrive::Snapshot& sn) {
+  if (lg.flush_req) {
+    if (!lg.buf[lg.active].len) {
+      lg.sync_req = true;
+      pros::Task(lg.writer).notify();
+      lg.flush_req = false;
+    } else if (hand_off(true)) {
+      lg.flush_req = false;
+    }
+  }
+  Buffer* b = &lg.buf[lg.active];
+  if (b->len + telemetry::TICK_MAX > sizeof b->data) {
+    if (!hand_off(false)) {
+      ++lg.stats.dropped_ticks;
+      ++lg.seq;  // shows up as a sequence gap in telem_decode
+      return;
+    }
+    b = &lg.buf[lg.active];
+  }
+  const size_t n = telemetry::pack_tick(sn, lg.seq, lg.stats.ticks % NAMES_EVERY == 0,
+                                        b->data + b->len, sizeof b->data - b->len);
+  b->len += n;
+  lg.stats.raw_bytes += n;
+  ++lg.stats.ticks;
+
+  PendingEvent ev;
+  while (b->len + EVENT_ENTRY <= sizeof b->data && lg.events.pop(ev)) {
+    uint8_t* p = b->data + b->len;
+    const uint16_t len = EVENT_ENTRY - 2;
+    wire::put(p, len);
+    p = wire::put_header(p, {wire::EVENT, 0, lg.seq++, ev.t_us});
+    wire::put(p, static_cast<uint8_t>(ev.kind));
+    wire::put(p, ev.a);
+    wire::put(p, ev.b);
+    b->len += EVENT_ENTRY;
+    lg.stats.raw_bytes += EVENT_ENTRY;
+    ++lg.stats.events;
+  }
+  lg.stats.dropped_events = lg.dropped_events.load(std::memory_order_relaxed);
+}
+
+// ---- API ----
+bool start(const char* dir) {
+  if (lg.running) return true;
+#ifndef SIM
+  if (!pros::usd::is_installed()) return false;
+#endif
+  const size_t n = std::strlen(dir);
+  std::snprintf(lg.dir, sizeof lg.dir, "%s%s", dir, n && dir[n - 1] != '/' ? "/" : "");  // filenames go straight after it
+  lg.slot = (last_slot() + 1) % LOG_FILES;
+  lg.cur = open_slot(lg.slot);
+  if (!lg.cur) return false;
+  save_slot(lg.slot);
+  slot_path(lg.slot, lg.path, sizeof lg.path);
+
+  for (Buffer& b : lg.buf) { b.len = 0; b.sync = false; b.full = false; }
+  lg.active = lg.next = 0;
+  lg.cur_bytes = 0;
+  lg.stats = Stats{};
+  lg.stats.files = 1;
+  lg.flush_req = false;
+  lg.sync_req = false;
+  for (PendingEvent ev; lg.events.pop(ev);) {}
+  lg.dropped_events = 0;
+  lg.stopping = false;
+  lg.writer_done = false;
+  // Lowest user priority: it may block in fwrite() as long as it likes
+  if (!lg.writer)
+    lg.writer = static_cast<pros::task_t>(
+        pros::Task(writer_main, TASK_PRIORITY_MIN + 1, TASK_STACK_DEPTH_DEFAULT, "logger"));
+  lg.running = true;
+  xdrive::add_sample_hook(record);
+  return true;
+}
+
+void flush() {
+  if (lg.running) lg.flush_req = true;
+}
+
+void stop() {
+  if (!lg.running) return;
+  xdrive::remove_sample_hook(record);
+  pros::delay(20);  // let a tick already in record() finish
+  if (lg.buf[lg.active].len) {
+    while (!hand_off(true)) pros::delay(5);
+  }
+  lg.stopping = true;
+  pros::Task(lg.writer).notify();
+  while (!lg.writer_done) pros::delay(5);
+  lg.running = false;
+}
+
+void event(Event kind, int32_t a, int32_t b) {
+  if (!lg.running) return;
+  if (!lg.events.push({static_cast<uint32_t>(pros::micros()), kind, a, b}))
+    lg.dropped_events.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool running() { return lg.running; }
+const char* path() { return lg.path; }
+const Stats& stats() { return lg.stats; }
+
+#ifdef SIM
+// sim::kill_all_tasks() deleted the writer without stop(): close its files
+// and let the next start() make a new one. Unwritten buffers are lost.
+static void forget_writer() {
+  if (lg.running) xdrive::remove_sample_hook(record);
+  if (lg.cur) std::fclose(lg.cur);
+  if (lg.ahead) std::fclose(lg.ahead);
+  lg.cur = lg.ahead = nullptr;
+  lg.writer = nullptr;
+  lg.running = false;
+}
+[[maybe_unused]] static const bool writer_hooked = (sim::on_kill_all_tasks(forget_writer), true);
+#endif
+
+} // namespace logger
@@ -1,6 +1,18 @@
+#ifdef SIM
+#include "sim_compat.hpp"  // host emulation of the PROS API used below
+#else
 #include "main.h"
-#include "xdrive.hpp"
 #include "pros/misc.h"
+#endif
+#include "xdrive.hpp"
+#include "control.hpp"
+#include "telemetry.hpp"
+#include "logger.hpp"
+#include "localize.hpp"
+#include "routes.hpp"
+#if defined(BENCH) && !defined(SIM)
+#include "bench_suite.hpp"
+#endif
 
 using namespace pros;
 
@@ -30,8 +42,18 @@ void initialize() {
 	lcd::initialize();
 	lcd::print(0, "X-Drive Ready");
 
-	xdrive::initialize();  // calibrates IMU if configured
+	xdrive::initialize();  // starts IMU calibration in the background
+	xdrive::start_sensors();     // one device read per tick for every consumer
+	if (xdrive::POSE_ESTIMATOR)
+		localize::start();         // EKF pose for the screen, stream and log
+	if (xdrive::SD_LOG)
+		logger::start();           // every run to /usd/brlog_NN.bin (no-op without a card)
 	xdrive::start_telemetry();   // <-- start screen updates
+	if (xdrive::SERIAL_TELEMETRY)
+		telemetry::start_stream(xdrive::SERIAL_LZ4);  // decode with bin/host/telem_decode
+#if defined(BENCH) && !defined(SIM)
+	bench::run_on_target();      // `make BENCH=1`: time the hot paths on the brain
+#endif
 }
 
 /**
@@ -39,7 +61,11 @@ void initialize() {
  * the VEX Competition Switch, following either autonomous or opcontrol. When
  * the robot is enabled, this task will exit.
  */
-void disabled() {}
+void disabled() {
+	xdrive::stop_motion();
+	logger::event(logger::Event::MODE, 0);
+	logger::flush();  // the run so far onto the card before power-off
+}
 
 /**
  * Runs after initialize(), and before autonomous when connected to the Field
@@ -52,6 +78,47 @@ void disabled() {}
  */
 void competition_initialize() {}
 
+// Wait for a move and log how it ended.
+static void finish(xdrive::Motion m) {
+	m.wait();
+	const xdrive::MoveResult r = m.result();
+	logger::event(logger::Event::MOVE_END, static_cast<int32_t>(r.ms), r.settled);
+}
+
+// Follow routes::CURVE_TO_GOAL at 100 Hz on the localize pose, taken relative
+// to where autonomous started (the route's origin). Commands go out robot-frame,
+// turned with the estimate's heading rather than drive()'s IMU-only
+// field-centric mapping. False without a pose.
+static bool follow_route() {
+	if (!localize::running()) return false;
+	Pose p0;
+	for (int k = 0; k < 10 && !telemetry::latest_pose(p0); ++k) delay(10);  // first tick after boot
+	if (!telemetry::latest_pose(p0)) return false;
+	const follow::Path path(routes::CURVE_TO_GOAL.data(), routes::CURVE_TO_GOAL.size());
+	follow::Follower f(path);
+	const double c0 = std::cos(p0.theta), s0 = std::sin(p0.theta);
+	const uint32_t t0 = millis();
+	uint32_t release = t0;
+	double t = 0.0;
+	bool done = false;
+	while (t < path.duration() + 2.0) {
+		Pose p = p0;
+		telemetry::latest_pose(p);
+		const double dx = p.x - p0.x, dy = p.y - p0.y;
+		const Pose rel{c0 * dx + s0 * dy, c0 * dy - s0 * dx, Odom2WIMU::wrap(p.theta - p0.theta)};
+		const follow::Command c = f.update_robot(rel, t);
+		if ((done = f.done(t))) break;
+		xdrive::drive(c.fwd, c.str, c.rot);
+		Task::delay_until(&release, 10);
+		t = (millis() - t0) / 1000.0;
+	}
+	xdrive::drive(0, 0, 0);  // one braking tick, then coast (velocity control holds its last mv)
+	Task::delay_until(&release, 10);
+	xdrive::drive(0, 0, 0);
+	logger::event(logger::Event::MOVE_END, static_cast<int32_t>(millis() - t0), done);
+	return true;
+}
+
 /**
  * Runs the user autonomous code. This function will be started in its own task
  * with the default priority and stack size whenever the robot is enabled via
@@ -64,16 +131,35 @@ void competition_initialize() {}
  * from where it left off.
  */
 void autonomous() {
+	logger::event(logger::Event::MODE, 1);
+	if (xdrive::FOLLOW_ROUTES && follow_route()) return;
+	// Otherwise the same sweep as three encoder moves.
 	// Move ~24 inches forward (4" wheel default)
-  xdrive::drive_forward_deg(xdrive::inches_to_deg(24.0), 100);
-  delay(300);
-  // Strafe right 12 inches
-  xdrive::strafe_right_deg(xdrive::inches_to_deg(12.0), 100);
-  delay(300);
-  // Turn ~360 wheel degrees per side for a spin (tune!)
-  xdrive::turn_cw_deg(720, 100);
+	// Moves run in the xdrive motion task; mechanisms can run between start
+	// and wait().
+	finish(xdrive::drive_forward_async(xdrive::inches_to_deg(24.0), 100));
+	delay(300);
+	// Strafe right 12 inches
+	finish(xdrive::strafe_right_async(xdrive::inches_to_deg(12.0), 100));
+	delay(300);
+	// Turn ~360 wheel degrees per side for a spin (tune!)
+	finish(xdrive::turn_cw_async(720, 100));
 }
 
+// Sticks -> xdrive::drive() at a fixed 100 Hz, one priority above default
+// so telemetry and other user tasks cannot stretch the period.
+static Controller master(E_CONTROLLER_MASTER);
+
+static void drive_tick() {
+	const bool field = true; // toggle to enable field-centric (requires IMU)
+	int fwd = master.get_analog(E_CONTROLLER_ANALOG_LEFT_Y);   // forward/back
+	int str = master.get_analog(E_CONTROLLER_ANALOG_LEFT_X);   // strafe
+	int rot = master.get_analog(E_CONTROLLER_ANALOG_RIGHT_X);  // rotate
+	xdrive::drive(fwd, str, rot, field);
+}
+
+static control::Loop drive_loop("drive", 10, TASK_PRIORITY_DEFAULT + 1, drive_tick);
+
 /**
  * Runs the operator control code. This function will be started in its own task
  * with the default priority and stack size whenever the robot is enabled via
@@ -88,14 +174,7 @@ void autonomous() {
  * task, not resume it from where it left off.
  */
 void opcontrol() {
-	Controller master(pros::E_CONTROLLER_MASTER);
-	const bool field = true; // toggle to enable field-centric (requires IMU)
-
-	while (true) {
-		int fwd = master.get_analog(E_CONTROLLER_ANALOG_LEFT_Y);   // forward/back
-		int str = master.get_analog(E_CONTROLLER_ANALOG_LEFT_X);   // strafe
-		int rot = master.get_analog(E_CONTROLLER_ANALOG_RIGHT_X);  // rotate
-		xdrive::drive(fwd, str, rot, field);
-		delay(10);
-	}
-}
\ No newline at end of file
+	xdrive::stop_motion();  // an autonomous move may still be running
+	logger::event(logger::Event::MODE, 2);
+	drive_loop.run();  // never returns; the task is deleted when the mode ends
+}
@@ -3,44 +3,304 @@
 #ifdef SIM
   #include <cstdint>
   #include <cmath>
+  #include <algorithm>
 
-  // ---- Mock timing ----
+  // ---- Virtual clock ----
+  // now_ms()/sleep_ms() run on simulated time. sleep_ms() advances the clock
+  // and then paces against the wall clock depending on the mode:
+  //   RealTime : 1 sim second per wall second (old behaviour)
+  //   Scaled   : `scale` sim seconds per wall second
+  //   Fast     : never sleeps, runs as fast as the CPU allows
+  // The clock is per host thread so batch runners can keep one robot per thread.
   #include <chrono>
   #include <thread>
-  inline uint32_t now_ms() {
-    using namespace std::chrono;
-    static auto t0 = steady_clock::now();
-    return (uint32_t)duration_cast<milliseconds>(steady_clock::now() - t0).count();
+  #include <cstring>
+  #include <cstdlib>
+  namespace sim {
+    enum class ClockMode { RealTime, Scaled, Fast };
+
+    struct Clock {
+      uint64_t  now_us = 0;          // simulated time since reset
+      ClockMode mode   = ClockMode::RealTime;
+      double    scale  = 1.0;        // sim/wall ratio in Scaled mode
+      uint64_t  anchor_us = 0;       // sim time at the last pacing anchor
+      std::chrono::steady_clock::time_point anchor_wall = std::chrono::steady_clock::now();
+      // Installed by the task emulation (sim_pros.cpp) so sleep_ms() inside a
+      // task blocks that task instead of stalling the whole simulation.
+      void (*sleep_hook)(uint64_t us) = nullptr;
+    };
+
+    inline Clock& clock() { static thread_local Clock c; return c; }
+
+    inline void set_clock_mode(ClockMode m, double scale = 1.0) {
+      Clock& c = clock();
+      c.mode  = m;
+      c.scale = (m == ClockMode::RealTime || scale <= 0.0) ? 1.0 : scale;
+      c.anchor_us   = c.now_us;
+      c.anchor_wall = std::chrono::steady_clock::now();
+    }
+
+    // Rewind simulated time to zero (keeps the mode).
+    inline void reset_clock() {
+      clock().now_us = 0;
+      set_clock_mode(clock().mode, clock().scale);
+    }
+
+    inline uint64_t now_us() { return clock().now_us; }
+
+    inline void advance_us(uint64_t us) {
+      Clock& c = clock();
+      c.now_us += us;
+      if (c.mode == ClockMode::Fast) return;
+      // Sleep until the absolute wall deadline so pacing does not drift.
+      const double wall_us = (double)(c.now_us - c.anchor_us) / c.scale;
+      std::this_thread::sleep_until(c.anchor_wall +
+                                    std::chrono::microseconds((int64_t)wall_us));
+    }
+
+    // Strip clock flags from argv: --realtime, --fast, --scale=<x>.
+    // Returns the new argc; unknown arguments are kept in order.
+    inline int parse_clock_args(int argc, char** argv) {
+      int out = 1;
+      for (int i = 1; i < argc; ++i) {
+        if      (!std::strcmp(argv[i], "--realtime")) set_clock_mode(ClockMode::RealTime);
+        else if (!std::strcmp(argv[i], "--fast"))     set_clock_mode(ClockMode::Fast);
+        else if (!std::strncmp(argv[i], "--scale=", 8))
+          set_clock_mode(ClockMode::Scaled, std::atof(argv[i] + 8));
+        else argv[out++] = argv[i];
+      }
+      return out;
+    }
+  } // namespace sim
+
+  inline uint32_t now_ms() { return (uint32_t)(sim::now_us() / 1000); }
+  inline void sleep_ms(uint32_t ms){
+    if (sim::clock().sleep_hook) sim::clock().sleep_hook((uint64_t)ms * 1000);
+    else sim::advance_us((uint64_t)ms * 1000);
   }
-  inline void sleep_ms(uint32_t ms){ std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
 
-  // ---- Motor mock (captures last .move() command in [-127..127]) ----
+  // ---- Motor model ----
+  // Brushed DC motor behind a V5 cartridge: back-EMF, winding resistance,
+  // firmware current limit, rotor + wheel inertia and friction. Defaults give
+  // ~3600 rpm internal free speed at 12 V, i.e. 100/200/600 rpm per cartridge.
+  struct MotorModel {
+    double ke      = 12.0 / 377.0; // V*s/rad at the internal motor (== kt, N*m/A)
+    double R       = 4.8;          // ohm
+    double i_limit = 2.5;          // A, V5 firmware current limit
+    double j_rotor = 1.0e-6;       // kg*m^2, internal rotor
+    double j_load  = 4.4e-3;       // kg*m^2 at the output (1/4 of ~15 lb on a 4" wheel)
+    double b_load  = 1.0e-3;       // N*m*s/rad viscous at the output
+    double c_load  = 0.05;         // N*m Coulomb friction at the output
+    double eff     = 0.9;          // cartridge efficiency
+  };
+
+  // ---- Per-port command rings ----
+  // Every command a MotorMock accepts is stamped with sim time and appended to
+  // its port's ring, in the caller's frame (before `reversed`). The plant in
+  // sim_trial.hpp replays these, so it moves the chassis with exactly what the
+  // code under test emitted instead of re-deriving it.
+  namespace sim {
+    enum class CmdKind : uint8_t { Voltage, Velocity, Position };
+
+    struct MotorCmd {
+      uint64_t t_us;
+      CmdKind  kind;
+      double   value;  // mV, rpm or target position (encoder units)
+      double   duty;   // expected speed as a fraction of free speed, -1..1 (0 for Position)
+    };
+
+    struct CmdRing {
+      static constexpr uint64_t N = 64;
+      MotorCmd buf[N];
+      uint64_t head = 0;  // total commands ever pushed
+      void push(const MotorCmd& c){ buf[head++ % N] = c; }
+    };
+
+    constexpr int MAX_PORTS = 21;
+    inline CmdRing& cmd_ring(int port) {
+      static thread_local CmdRing rings[MAX_PORTS + 1];
+      return rings[(port < 0 || port > MAX_PORTS) ? 0 : port];
+    }
+
+    // Reader side: the command in effect at a given sim time. Starts at the
+    // ring's current head, so stale commands from an earlier run are skipped.
+    // A reader that falls more than N commands behind drops the oldest.
+    struct CmdCursor {
+      int port; uint64_t tail; MotorCmd cur{0, CmdKind::Voltage, 0.0, 0.0};
+      explicit CmdCursor(int p): port(p), tail(cmd_ring(p).head) {}
+      const MotorCmd& at(uint64_t t_us){
+        const CmdRing& r = cmd_ring(port);
+        if (r.head - tail > CmdRing::N) tail = r.head - CmdRing::N;
+        while (tail < r.head && r.buf[tail % CmdRing::N].t_us <= t_us) cur = r.buf[tail++ % CmdRing::N];
+        return cur;
+      }
+    };
+  } // namespace sim
+
+  // ---- Motor mock ----
+  // Integrates the model lazily up to sim::now_us() (1 ms substeps) whenever
+  // it is touched, so code that sleeps on the virtual clock sees the motor move.
+  // Voltage (move/move_voltage), velocity (move_velocity) and position
+  // (move_relative/move_absolute) control mirror the V5 onboard modes; the
+  // position/velocity loops emulate the firmware PID with plain P/PI gains.
+  // Each command is also logged to sim::cmd_ring(port).
   struct MotorMock {
+    enum class Mode { Voltage, Velocity, Position };
+
     int port; bool reversed=false;
     int last_cmd=0; // -127..127
-    double sim_rpm=0.0;  // optional “measured” speed
+    double sim_rpm=0.0;  // measured output speed (rpm)
+    MotorModel model;
+
     explicit MotorMock(int p, bool rev=false): port(p), reversed(rev) {}
-    void set_gearing(int){};
-    void set_encoder_units(int){};
+    void set_gearing(int g){ sync(); gearset = g; }
+    void set_encoder_units(int u){ sync(); units = u; }
     void set_reversed(bool r){ reversed=r; }
-    void move(int v){ last_cmd = reversed ? -v : v; }
-    void move_relative(double /*deg*/, int /*spd*/){ /*no-op*/ }
-    void tare_position(){ }
-    double get_position() const { return 0.0; }
-    double get_voltage()  const { return last_cmd/127.0 * 12000.0; }
-    double get_actual_velocity() const { return sim_rpm; }
+
+    void move(int v){
+      sync();
+      v = std::max(-127, std::min(127, v));
+      record(sim::CmdKind::Voltage, v / 127.0 * 12000.0, steady_duty(v / 127.0 * 12.0));
+      last_cmd = reversed ? -v : v;
+      mode = Mode::Voltage; cmd_mv = last_cmd / 127.0 * 12000.0;
+    }
+    void move_voltage(int mv){
+      sync();
+      mv = std::max(-12000, std::min(12000, mv));
+      record(sim::CmdKind::Voltage, mv, steady_duty(mv / 1000.0));
+      cmd_mv = reversed ? -mv : mv;
+      last_cmd = (int)(cmd_mv / 12000.0 * 127.0);
+      mode = Mode::Voltage;
+    }
+    void move_velocity(int rpm){
+      sync();
+      record(sim::CmdKind::Velocity, rpm, std::max(-1.0, std::min(1.0, rpm / free_rpm())));
+      vel_sp = reversed ? -rpm : rpm; vel_i = 0.0;
+      mode = Mode::Velocity;
+    }
+    void move_absolute(double pos, int spd){
+      sync();
+      record(sim::CmdKind::Position, pos, 0.0);
+      target_deg = from_units(reversed ? -pos : pos);
+      vmax_rpm = std::min(std::abs((double)spd), free_rpm()); vel_i = 0.0;
+      mode = Mode::Position;
+    }
+    void move_relative(double delta, int spd){
+      sync();
+      const double base = (mode == Mode::Position) ? target_deg : theta_deg;
+      target_deg = base + from_units(reversed ? -delta : delta);
+      record(sim::CmdKind::Position, to_units(reversed ? -target_deg : target_deg), 0.0);
+      vmax_rpm = std::min(std::abs((double)spd), free_rpm()); vel_i = 0.0;
+      mode = Mode::Position;
+    }
+    void tare_position(){ sync(); target_deg -= theta_deg; theta_deg = 0.0; }
+
+    double get_position(){ sync(); return to_units(reversed ? -theta_deg : theta_deg); }
+    double get_target_position(){ sync(); return to_units(reversed ? -target_deg : target_deg); }
+    double get_voltage(){ sync(); return reversed ? -applied_mv : applied_mv; }
+    double get_actual_velocity(){ sync(); return reversed ? -sim_rpm : sim_rpm; }
+    double get_current_draw(){ sync(); return std::abs(current_a) * 1000.0; }
+
+    double ratio() const { return gearset == 0 ? 36.0 : gearset == 2 ? 6.0 : 18.0; }
+    double free_rpm() const { return 12.0 / model.ke / ratio() * 60.0 / (2.0 * M_PI); }
+
+    // Speed the loaded wheel settles at under a constant `volts`, as a share of
+    // free_rpm(): back-EMF plus the voltage needed to hold the Coulomb and
+    // viscous friction torque (current limit not reached in steady state).
+    double steady_duty(double volts) const {
+      const double N = ratio(), kt = model.ke * N * model.eff;
+      const double v_static = model.R * model.c_load / kt;
+      const double w = std::max(0.0, std::abs(volts) - v_static) / (model.ke * N + model.R * model.b_load / kt);
+      return std::copysign(std::min(1.0, w * 60.0 / (2.0 * M_PI) / free_rpm()), volts);
+    }
+
+    // Advance the model to the current simulated time.
+    void sync(){
+      const uint64_t now = sim::now_us();
+      if (now < last_us) last_us = now;       // clock was reset
+      while (now - last_us >= STEP_US) { step(STEP_US * 1e-6); last_us += STEP_US; }
+    }
+
+   private:
+    static constexpr uint64_t STEP_US = 1000;
+    // Firmware loop gains (per-cartridge scaled through free_rpm()).
+    static constexpr double KP_POS = 2.0;   // rpm per degree of error
+    static constexpr double KP_VEL = 0.02;  // V per rpm error, at 200 rpm
+    static constexpr double KI_VEL = 0.2;   // V per rpm*s, at 200 rpm
+
+    int gearset = 1, units = 0;             // E_MOTOR_GEARSET_18, degrees
+    Mode mode = Mode::Voltage;
+    double cmd_mv = 0.0, applied_mv = 0.0, current_a = 0.0;
+    double vel_sp = 0.0, vel_i = 0.0, target_deg = 0.0, vmax_rpm = 0.0;
+    double theta_deg = 0.0, omega = 0.0;    // output shaft, motor frame
+    uint64_t last_us = sim::now_us();
+
+    void record(sim::CmdKind k, double value, double duty){
+      sim::cmd_ring(port).push({sim::now_us(), k, value, duty});
+    }
+
+    // Encoder counts per output revolution: 1800 / 900 / 300.
+    double counts_per_rev() const { return 50.0 * ratio(); }
+    double to_units(double deg) const {
+      return units == 1 ? deg / 360.0 : units == 2 ? deg * counts_per_rev() / 360.0 : deg;
+    }
+    double from_units(double u) const {
+      return units == 1 ? u * 360.0 : units == 2 ? u * 360.0 / counts_per_rev() : u;
+    }
+
+    double velocity_loop(double sp_rpm, double dt) {
+      const double k = 200.0 / free_rpm();  // same loop bandwidth on every cartridge
+      const double err = sp_rpm - sim_rpm;
+      vel_i = std::max(-12.0, std::min(12.0, vel_i + KI_VEL * k * err * dt));
+      return sp_rpm * 12.0 / free_rpm() + KP_VEL * k * err + vel_i;
+    }
+
+    void step(double dt) {
+      double v;
+      switch (mode) {
+        case Mode::Voltage:  v = cmd_mv / 1000.0; break;
+        case Mode::Velocity: v = velocity_loop(vel_sp, dt); break;
+        default: {
+          const double sp = std::max(-vmax_rpm, std::min(vmax_rpm, KP_POS * (target_deg - theta_deg)));
+          v = velocity_loop(sp, dt);
+        }
+      }
+      v = std::max(-12.0, std::min(12.0, v));
+      applied_mv = v * 1000.0;
+
+      const double N = ratio(), wm = omega * N;
+      current_a = std::max(-model.i_limit, std::min(model.i_limit, (v - model.ke * wm) / model.R));
+      const double tau_drive = model.ke * current_a * N * model.eff;
+      const double tau_visc  = model.b_load * omega;
+      const double J = model.j_load + model.j_rotor * N * N;
+
+      // Coulomb friction holds the wheel still until the drive torque beats it.
+      if (omega == 0.0 && std::abs(tau_drive) <= model.c_load) return;
+      const double tau_fric = model.c_load * (omega != 0.0 ? (omega > 0 ? 1.0 : -1.0)
+                                                           : (tau_drive > 0 ? 1.0 : -1.0));
+      const double w_new = omega + (tau_drive - tau_visc - tau_fric) / J * dt;
+      // Friction cannot reverse the wheel within a step.
+      omega = (omega != 0.0 && (w_new > 0) != (omega > 0) && std::abs(tau_drive) <= model.c_load)
+                ? 0.0 : w_new;
+      theta_deg += omega * dt * 180.0 / M_PI;
+      sim_rpm = omega * 60.0 / (2.0 * M_PI);
+    }
   };
 
   struct ImuMock {
     double heading_deg = 0.0; // 0..360
-    void reset(){ heading_deg = 0.0; }
-    bool is_calibrating() const { return false; }
+    uint32_t cal_ms = 0;      // calibration time after reset()
+    uint64_t cal_end_us = 0;
+    void reset(){ heading_deg = 0.0; cal_end_us = sim::now_us() + (uint64_t)cal_ms * 1000; }
+    bool is_calibrating() const { return sim::now_us() < cal_end_us; }
     double get_heading() const { return heading_deg; }
     double get_rotation() const { return heading_deg; }
   };
 
   inline double deg2rad(double d){ return d*M_PI/180.0; }
 
+  #include "sim_pros.hpp"
+
 #else
   // ---- Real PROS adapters ----
   #include "api.h"
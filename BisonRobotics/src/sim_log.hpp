@@ -0,0 +1,264 @@
+#pragma once
+
+#ifdef SIM
+// ---- Columnar binary sim log (.brlg) ----
+// Layout (little-endian, every block 8-byte aligned):
+//   header : "BRLG" u16 version u16 ncols u32 chunk_rows
+//            ncols x { u8 type, u8 precision, u8 name_len, name[name_len] }
+//            zero pad to 8
+//   chunk* : "CHNK" u32 nrows, then per column nrows values, each column
+//            zero padded to 8
+// Rows are buffered per column and written a chunk at a time, so writing is a
+// few large fwrite()s. The reader maps the file and hands out typed pointers
+// straight into the mapping; nothing is parsed or copied per sample. A chunk
+// cut short by a crash is ignored.
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace sim {
+
+enum class ColType : uint8_t { F64 = 0, F32 = 1, I32 = 2, U32 = 3, I64 = 4 };
+
+inline size_t col_size(ColType t) {
+  return (t == ColType::F64 || t == ColType::I64) ? 8 : 4;
+}
+
+struct Column {
+  std::string name;
+  ColType type = ColType::F64;
+  uint8_t precision = 4;  // decimals when printed as CSV
+};
+
+namespace brlg {
+  constexpr char     MAGIC[4]  = {'B', 'R', 'L', 'G'};
+  constexpr char     CHUNK[4]  = {'C', 'H', 'N', 'K'};
+  constexpr uint16_t VERSION   = 1;
+  inline size_t pad8(size_t n) { return (n + 7) & ~size_t(7); }
+}
+
+// ---- Writer ----
+class LogWriter {
+ public:
+  LogWriter(const char* path, std::vector<Column> schema, uint32_t chunk_rows = 8192)
+      : cols_(std::move(schema)), chunk_rows_(chunk_rows ? chunk_rows : 1) {
+    f_ = std::fopen(path, "wb");
+    bufs_.resize(cols_.size());
+    for (size_t c = 0; c < cols_.size(); ++c)
+      bufs_[c].resize(brlg::pad8(col_size(cols_[c].type) * chunk_rows_));
+    if (f_) write_header();
+  }
+  ~LogWriter() { close(); }
+  LogWriter(const LogWriter&) = delete;
+  LogWriter& operator=(const LogWriter&) = delete;
+
+  bool ok() const { return f_ != nullptr; }
+  size_t columns() const { return cols_.size(); }
+
+  // Append one row, one value per column in schema order.
+  void push(const double* row) {
+    for (size_t c = 0; c < cols_.size(); ++c) put(c, row[c]);
+    if (++n_ == chunk_rows_) flush();
+  }
+  void push(std::initializer_list<double> row) { push(row.begin()); }
+
+  // Write the buffered partial chunk.
+  void flush() {
+    if (!f_ || n_ == 0) return;
+    const uint32_t n = n_;
+    std::fwrite(brlg::CHUNK, 1, 4, f_);
+    std::fwrite(&n, 4, 1, f_);
+    for (size_t c = 0; c < cols_.size(); ++c) {
+      const size_t bytes = col_size(cols_[c].type) * n, padded = brlg::pad8(bytes);
+      std::memset(bufs_[c].data() + bytes, 0, padded - bytes);
+      std::fwrite(bufs_[c].data(), 1, padded, f_);
+    }
+    n_ = 0;
+  }
+
+  void close() {
+    if (!f_) return;
+    flush();
+    std::fclose(f_);
+    f_ = nullptr;
+  }
+
+ private:
+  void put(size_t c, double v) {
+    uint8_t* p = bufs_[c].data() + col_size(cols_[c].type) * n_;
+    switch (cols_[c].type) {
+      case ColType::F64: { double   x = v;            std::memcpy(p, &x, 8); break; }
+      case ColType::F32: { float    x = (float)v;     std::memcpy(p, &x, 4); break; }
+      case ColType::I32: { int32_t  x = (int32_t)v;   std::memcpy(p, &x, 4); break; }
+      case ColType::U32: { uint32_t x = (uint32_t)v;  std::memcpy(p, &x, 4); break; }
+      case ColType::I64: { int64_t  x = (int64_t)v;   std::memcpy(p, &x, 8); break; }
+    }
+  }
+
+  void write_header() {
+    std::vector<uint8_t> h(brlg::MAGIC, brlg::MAGIC + 4);
+    auto u16 = [&](uint16_t v){ h.push_back(v & 0xFF); h.push_back(v >> 8); };
+    u16(brlg::VERSION);
+    u16((uint16_t)cols_.size());
+    for (int i = 0; i < 4; ++i) h.push_back((chunk_rows_ >> (8 * i)) & 0xFF);
+    for (const Column& c : cols_) {
+      h.push_back((uint8_t)c.type);
+      h.push_back(c.precision);
+      h.push_back((uint8_t)c.name.size());
+      h.insert(h.end(), c.name.begin(), c.name.end());
+    }
+    h.resize(brlg::pad8(h.size()), 0);
+    std::fwrite(h.data(), 1, h.size(), f_);
+  }
+
+  std::FILE* f_ = nullptr;
+  std::vector<Column> cols_;
+  std::vector<std::vector<uint8_t>> bufs_;
+  uint32_t chunk_rows_, n_ = 0;
+};
+
+// ---- Memory-mapped reader ----
+class LogReader {
+ public:
+  struct Chunk { uint32_t rows; std::vector<const uint8_t*> col; };
+
+  explicit LogReader(const char* path) {
+    if (!map(path)) return;
+    ok_ = parse();
+  }
+  ~LogReader() { unmap(); }
+  LogReader(const LogReader&) = delete;
+  LogReader& operator=(const LogReader&) = delete;
+
+  bool ok() const { return ok_; }
+  const std::vector<Column>& columns() const { return cols_; }
+  const std::vector<Chunk>& chunks() const { return chunks_; }
+  uint64_t rows() const { return rows_; }
+
+  int find(const char* name) const {
+    for (size_t c = 0; c < cols_.size(); ++c) if (cols_[c].name == name) return (int)c;
+    return -1;
+  }
+
+  // Zero-copy typed view of column `c` in chunk `k` (T must match the type).
+  template <class T> const T* data(size_t k, size_t c) const {
+    return reinterpret_cast<const T*>(chunks_[k].col[c]);
+  }
+
+  // Element `i` of a chunk column, widened to double.
+  double value(size_t k, size_t c, size_t i) const {
+    const uint8_t* p = chunks_[k].col[c] + col_size(cols_[c].type) * i;
+    switch (cols_[c].type) {
+      case ColType::F64: { double   x; std::memcpy(&x, p, 8); return x; }
+      case ColType::F32: { float    x; std::memcpy(&x, p, 4); return x; }
+      case ColType::I32: { int32_t  x; std::memcpy(&x, p, 4); return x; }
+      case ColType::U32: { uint32_t x; std::memcpy(&x, p, 4); return x; }
+      case ColType::I64: { int64_t  x; std::memcpy(&x, p, 8); return (double)x; }
+    }
+    return 0.0;
+  }
+
+  // Whole column as doubles (copies; use data<T>() for the zero-copy path).
+  std::vector<double> column(size_t c) const {
+    std::vector<double> out;
+    out.reserve(rows_);
+    for (size_t k = 0; k < chunks_.size(); ++k)
+      for (uint32_t i = 0; i < chunks_[k].rows; ++i) out.push_back(value(k, c, i));
+    return out;
+  }
+
+ private:
+  bool parse() {
+    const uint8_t* p = base_;
+    const uint8_t* end = base_ + size_;
+    if (size_ < 12 || std::memcmp(p, brlg::MAGIC, 4) != 0) return false;
+    uint16_t ver, ncols;
+    std::memcpy(&ver, p + 4, 2);
+    std::memcpy(&ncols, p + 6, 2);
+    if (ver != brlg::VERSION) return false;
+    p += 12;
+    for (uint16_t c = 0; c < ncols; ++c) {
+      if (end - p < 3) return false;
+      Column col;
+      col.type = (ColType)p[0];
+      col.precision = p[1];
+      const uint8_t len = p[2];
+      p += 3;
+      if (end - p < len) return false;
+      col.name.assign((const char*)p, len);
+      p += len;
+      cols_.push_back(col);
+    }
+    p = base_ + brlg::pad8(p - base_);
+    while (end - p >= 8 && std::memcmp(p, brlg::CHUNK, 4) == 0) {
+      Chunk ch;
+      std::memcpy(&ch.rows, p + 4, 4);
+      const uint8_t* q = p + 8;
+      for (const Column& col : cols_) {
+        const size_t bytes = brlg::pad8(col_size(col.type) * ch.rows);
+        if ((size_t)(end - q) < bytes) return true;  // truncated tail
+        ch.col.push_back(q);
+        q += bytes;
+      }
+      rows_ += ch.rows;
+      chunks_.push_back(std::move(ch));
+      p = q;
+    }
+    return true;
+  }
+
+#ifdef _WIN32
+  bool map(const char* path) {
+    file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(file_, &sz) || sz.QuadPart == 0) return false;
+    size_ = (size_t)sz.QuadPart;
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) return false;
+    base_ = (const uint8_t*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    return base_ != nullptr;
+  }
+  void unmap() {
+    if (base_) UnmapViewOfFile(base_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+  }
+  HANDLE file_ = INVALID_HANDLE_VALUE, mapping_ = nullptr;
+#else
+  bool map(const char* path) {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+    size_ = (size_t)st.st_size;
+    void* m = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) return false;
+    base_ = (const uint8_t*)m;
+    return true;
+  }
+  void unmap() { if (base_) munmap((void*)base_, size_); }
+#endif
+
+  const uint8_t* base_ = nullptr;
+  size_t size_ = 0;
+  bool ok_ = false;
+  std::vector<Column> cols_;
+  std::vector<Chunk> chunks_;
+  uint64_t rows_ = 0;
+};
+
+} // namespace sim
+#endif
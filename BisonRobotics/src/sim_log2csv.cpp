@@ -0,0 +1,42 @@
+#ifdef SIM
+// Convert a .brlg sim log back to the CSV layout of odom_log.csv (the same
+// 10 columns as `sim --csv`); --all also writes the replay columns after them.
+// Build: g++ -DSIM -O2 -std=gnu++17 -Iinclude -o sim_log2csv src/sim_log2csv.cpp
+// Usage: sim_log2csv [--all] in.brlg [out.csv]     (stdout if no output given)
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "sim_log.hpp"
+
+constexpr size_t CSV_COLUMNS = 10;  // time_s .. dr, first in every sim log
+
+int main(int argc, char** argv) {
+  const bool all = argc > 1 && !std::strcmp(argv[1], "--all");
+  if (all) { --argc; ++argv; }
+  if (argc < 2) { std::fprintf(stderr, "usage: sim_log2csv [--all] in.brlg [out.csv]\n"); return 2; }
+  sim::LogReader log(argv[1]);
+  if (!log.ok()) { std::fprintf(stderr, "%s: not a readable .brlg log\n", argv[1]); return 1; }
+
+  std::FILE* out = argc > 2 ? std::fopen(argv[2], "w") : stdout;
+  if (!out) { std::perror(argv[2]); return 1; }
+  static char buf[1 << 16];
+  std::setvbuf(out, buf, _IOFBF, sizeof buf);
+
+  const auto& cols = log.columns();
+  const size_t ncols = all ? cols.size() : std::min(cols.size(), CSV_COLUMNS);
+  for (size_t c = 0; c < ncols; ++c)
+    std::fprintf(out, "%s%s", c ? ", " : "", cols[c].name.c_str());
+  std::fputc('\n', out);
+
+  for (size_t k = 0; k < log.chunks().size(); ++k) {
+    for (uint32_t i = 0; i < log.chunks()[k].rows; ++i) {
+      for (size_t c = 0; c < ncols; ++c)
+        std::fprintf(out, "%s%.*f", c ? ", " : "", cols[c].precision, log.value(k, c, i));
+      std::fputc('\n', out);
+    }
+  }
+  if (out != stdout) std::fclose(out);
+  return 0;
+}
+#endif
@@ -1,113 +1,166 @@
 #ifdef SIM
+// Host simulator.
+// Build: g++ -DSIM -O2 -std=gnu++17 -Iinclude -o sim
+//          src/sim_main.cpp src/main.cpp src/telemetry.cpp src/logger.cpp src/localize.cpp
+//          src/xdrive.cpp src/control.cpp src/sim_pros.cpp
 #include <cstdio>
+#include <cstring>
 #include <vector>
 #include <cmath>
 #include "xdrive.hpp"
 #include "odom.hpp"
+#include "routes.hpp"
 #include "sim_compat.hpp"
+#include "sim_trial.hpp"
+#include "sim_log.hpp"
+
+// Run the blocking autonomous helpers on the motor model (same sequence as
+// autonomous() in main.cpp) and report how each move ended.
+static void run_auto_helpers() {
+  std::printf("%-22s %8s %10s %10s\n", "move", "ms", "overshoot", "error");
+  for (const sim::RouteStep& s : sim::run_auto_route())
+    std::printf("%-22s %8u %10.2f %10.2f%s\n", s.name, (unsigned)s.r.ms, s.r.overshoot_deg,
+                s.r.error_deg, s.r.settled ? "" : "  (timeout)");
+  std::printf("%-22s %8u\n", "total", (unsigned)now_ms());
+}
+
+// Follow routes::CURVE_TO_GOAL and print the tracking error every 0.25 s.
+static void run_follow_demo(const OdomConfig& cfg) {
+  const follow::Path path(routes::CURVE_TO_GOAL.data(), routes::CURVE_TO_GOAL.size());
+  std::printf("%6s %8s %8s %8s %8s %8s\n", "t_s", "ref_x", "ref_y", "gt_x", "gt_y", "err_in");
+  const sim::FollowResult r = sim::run_follow(path, cfg, [&](const sim::Sample& s) {
+    if (std::lround(s.t * 100) % 25) return;
+    const follow::Ref ref = path.at(s.t);
+    std::printf("%6.2f %8.2f %8.2f %8.2f %8.2f %8.2f\n", s.t, ref.p.x, ref.p.y, s.gt.x, s.gt.y,
+                std::hypot(ref.p.x - s.gt.x, ref.p.y - s.gt.y));
+  });
+  std::printf("%s after %.2f s (path %.2f s): pose (%.2f, %.2f, %.1f deg), max error %.2f in\n",
+              r.done ? "done" : "timeout", r.t_s, path.duration(), r.gt.x, r.gt.y,
+              r.gt.theta * 180.0 / M_PI, r.max_err_xy);
+}
+
+// The match and boot runs have no trial loop feeding the IMU mock: a "field"
+// task runs a plant on the motor commands and turns the IMU with it, so the
+// heading, field-centric drive and the localize pose follow the robot.
+static void start_field() {
+  pros::Task([]{
+    sim::Plant plant({0, 0, 0});
+    for (;;) {
+      plant.advance_to(sim::now_us());
+      xdrive::sim_set_heading(plant.pose().theta * 180.0 / M_PI);
+      pros::delay(10);
+    }
+  }, "field");
+}
+
+// Run the real competition entry points from main.cpp on the emulated PROS
+// scheduler: initialize(), 15 s of autonomous(), then opcontrol() with the
+// joystick plan played on the master controller. Prints the LCD telemetry.
+static void run_match() {
+  auto show = [](const char* mode) {
+    std::printf("%7.2f s  %-6s | %s | %s | %s | %s\n", now_ms() / 1000.0, mode,
+                sim::lcd_line(1), sim::lcd_line(2), sim::lcd_line(3), sim::lcd_line(4));
+  };
+
+  pros::Task init_task([]{ ::initialize(); }, "initialize");
+  init_task.join();
+  start_field();
+
+  pros::Task auton([]{ autonomous(); }, "autonomous");
+  for (int k = 0; k < 30; ++k) { pros::delay(500); show("auto"); }
+  auton.remove();
+
+  pros::Task op([]{ opcontrol(); }, "opcontrol");
+  auto& master = sim::controller().analog[pros::E_CONTROLLER_MASTER];
+  for (const sim::Cmd& c : sim::default_plan()) {
+    master[pros::E_CONTROLLER_ANALOG_LEFT_Y]  = c.fwd;
+    master[pros::E_CONTROLLER_ANALOG_LEFT_X]  = c.str;
+    master[pros::E_CONTROLLER_ANALOG_RIGHT_X] = c.rot;
+    pros::delay((uint32_t)(c.t_s * 1000));
+    show("driver");
+  }
+  pros::delay(100);  // let telemetry refresh the loop timing lines
+  for (int line = 5; line < 8; ++line)
+    if (*sim::lcd_line(line)) std::printf("%7s           %s\n", "", sim::lcd_line(line));
+  op.remove();
+  xdrive::stop_telemetry();
+  sim::kill_all_tasks();
+}
 
-using xdrive::drive;
-
-// Convert 4 wheel commands (what your code sends) back into chassis commands.
-// Your mapping is:
-//   fl = df + ds + dr
-//   fr = df - ds - dr
-//   bl = df - ds + dr
-//   br = df + ds - dr
-// So invert:
-//   df = (fl+fr+bl+br)/4
-//   ds = (fl - fr - bl + br)/4
-//   dr = (fl - fr + bl - br)/4
-struct WheelCmd { double fl, fr, bl, br; };
-
-// Read the last commanded values from the mocks
-static WheelCmd read_wheels() {
-  // accesses the internal mocks via the voltage trick (proportional)
-  // but we don't have direct globals here; instead, we’ll call drive() and
-  // immediately infer from the arguments we used. To keep it simple, we
-  // just store/compute the df,ds,dr directly in the pattern below.
-  return {0,0,0,0}; // placeholder (we compute from df,ds,dr where we call drive)
+// Boot with a 2 s IMU calibration: initialize() from main.cpp returns at
+// once, the sticks drive robot-centric straight away and field-centric takes
+// over when the IMU reports calibrated.
+static void run_boot() {
+  xdrive::sim_set_imu_calibration_ms(2000);
+  const uint32_t t0 = now_ms();
+  pros::Task init_task([]{ ::initialize(); }, "initialize");
+  init_task.join();
+  start_field();
+  std::printf("initialize() returned after %u ms\n", (unsigned)(now_ms() - t0));
+
+  // Print each mode change with the wheel voltages on the ticks either side.
+  xdrive::ImuState last = xdrive::ImuState::NONE;
+  double prev_mv = 0.0;
+  for (uint32_t t = 0; t < 3000; t += 10) {
+    xdrive::drive(100, 0, 0, true);  // field-centric requested throughout
+    pros::delay(10);
+    const xdrive::ImuState st = xdrive::imu_state();
+    const double mv = xdrive::sensors().mv[0];
+    if (st != last)
+      std::printf("%5u ms  %-13s FL %5.0f -> %5.0f mV\n", (unsigned)(now_ms() - t0),
+                  st == xdrive::ImuState::READY ? "field-centric" : "robot-centric", prev_mv, mv);
+    last = st;
+    prev_mv = mv;
+  }
+  xdrive::drive(0, 0, 0, false);
+  sim::kill_all_tasks();
 }
 
-struct Cmd { double t_s; int fwd, str, rot; bool field; };
+// Usage: sim [--realtime | --scale=<x> | --fast] [--auto | --match | --follow | --boot | --csv | out.brlg]
+//   default writes odom_log.brlg (see sim_log2csv); --csv prints CSV to stdout
+int main(int argc, char** argv) {
+  argc = sim::parse_clock_args(argc, argv);
 
-int main() {
   // ---- Initialize (no hardware) ----
   xdrive::initialize();
 
+  if (argc > 1 && !std::strcmp(argv[1], "--auto"))  { run_auto_helpers(); return 0; }
+  if (argc > 1 && !std::strcmp(argv[1], "--match")) { run_match(); return 0; }
+  if (argc > 1 && !std::strcmp(argv[1], "--boot"))  { run_boot(); return 0; }
+
   // ---- Odometry model (2 wheels + IMU) ----
   OdomConfig cfg; cfg.L_par=3.0; cfg.L_perp=4.0; cfg.start={0,0,0};
-  Odom2WIMU odom(cfg);
-
-  // ---- Simple command script (joystick space) ----
-  std::vector<Cmd> plan = {
-    {2.0, +90,   0,   0, false},  // forward
-    {1.0,   0, +90,   0, false},  // right
-    {1.5,   0,   0, +90, false},  // rotate CW (positive in your mapping)
-    {1.0, +64, +64,   0, false},  // diagonal
-  };
 
-  // Scaling joystick to physical motion (tune these to your robot feel)
-  const double max_v_ips   = 30.0;     // “full stick forward” inches/sec
-  const double max_w_rps   = M_PI/1.0; // “full stick rot” rad/sec  (180°/s)
-  const double dt          = 0.01;
-
-  // Ground truth pose (what we integrate from joystick intent)
-  Pose gt{0,0,0};
-
-  std::puts("time_s, gt_x, gt_y, gt_th, est_x, est_y, est_th, df, ds, dr");
-
-  double t=0.0;
-  for (auto c: plan) {
-    const int steps = (int)std::round(c.t_s/dt);
-    for (int k=0; k<steps; ++k) {
-      // ---- Call your drive() just like teleop would ----
-      drive(c.fwd, c.str, c.rot, c.field);
-
-      // Recreate df,ds,dr exactly as your code does (deadband + square)
-      auto db = [](int v){ return (std::abs(v) < xdrive::DEADBAND) ? 0 : v; };
-      auto sq = [](int v){ double s=v/127.0; return std::copysign(s*s,s)*127.0; };
-      const int f = db(c.fwd), s = db(c.str), r = db(c.rot);
-      const double df = xdrive::SQUARE_INPUTS ? sq(f) : f;
-      const double ds = xdrive::SQUARE_INPUTS ? sq(s) : s;
-      const double dr = xdrive::SQUARE_INPUTS ? sq(r) : r;
-
-      // Map joystick-space to physical velocities
-      const double vy_r = (df/127.0) * max_v_ips;  // +forward
-      const double vx_r = (ds/127.0) * max_v_ips;  // +right
-      const double w    = (dr/127.0) * max_w_rps;  // +CCW (note: your +rot is CW; adjust sign)
-      // Your mapping labeled +dr as CW; odom assumes +theta is CCW.
-      // Flip sign for physics:
-      const double omega = -w;
-
-      // Integrate GT in field frame (midpoint)
-      const double thm = gt.theta + 0.5*omega*dt;
-      const double cth = std::cos(thm), sth = std::sin(thm);
-      gt.x += ( cth*vx_r - sth*vy_r) * dt;
-      gt.y += ( sth*vx_r + cth*vy_r) * dt;
-      gt.theta = Odom2WIMU::wrap(gt.theta + omega*dt);
-
-      // Tracking-wheel deltas from robot-centric dx,dy and dtheta
-      const double dx_r = vx_r*dt, dy_r = vy_r*dt, dth = omega*dt;
-      const double sPar  = dy_r - cfg.L_par  * dth;
-      const double sPerp = dx_r + cfg.L_perp * dth;
-
-      // IMU heading is absolute field orientation
-      const double imu_heading_rad = gt.theta;
-
-      // Feed odometry
-      odom.update(sPar, sPerp, imu_heading_rad);
-
-      // Log
-      const Pose est = odom.pose();
-      std::printf("%.3f, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f, %.2f, %.2f, %.2f\n",
-                  t, gt.x, gt.y, gt.theta, est.x, est.y, est.theta, df, ds, dr);
+  if (argc > 1 && !std::strcmp(argv[1], "--follow")) { run_follow_demo(cfg); return 0; }
 
-      t += dt;
-      sleep_ms((uint32_t)(dt*1000));
-    }
+  if (argc > 1 && !std::strcmp(argv[1], "--csv")) {
+    std::puts("time_s, gt_x, gt_y, gt_th, est_x, est_y, est_th, df, ds, dr");
+    sim::run_plan(sim::default_plan(), cfg, sim::Perturb{}, 0, [](const sim::Sample& s) {
+      std::printf("%.3f, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f, %.2f, %.2f, %.2f\n",
+                  s.t, s.gt.x, s.gt.y, s.gt.theta, s.est.x, s.est.y, s.est.theta,
+                  s.df, s.ds, s.dr);
+    });
+    return 0;
   }
 
+  // Binary log: the CSV columns plus the raw odometry inputs and sticks for
+  // replay (sim_replay).
+  const char* path = argc > 1 ? argv[1] : "odom_log.brlg";
+  sim::LogWriter log(path, {
+    {"time_s", sim::ColType::F64, 3},
+    {"gt_x",   sim::ColType::F64, 4}, {"gt_y",  sim::ColType::F64, 4}, {"gt_th",  sim::ColType::F64, 4},
+    {"est_x",  sim::ColType::F64, 4}, {"est_y", sim::ColType::F64, 4}, {"est_th", sim::ColType::F64, 4},
+    {"df",     sim::ColType::F32, 2}, {"ds",    sim::ColType::F32, 2}, {"dr",     sim::ColType::F32, 2},
+    {"s_par",  sim::ColType::F64, 6}, {"s_perp", sim::ColType::F64, 6}, {"imu_th", sim::ColType::F64, 6},
+    {"js_fwd", sim::ColType::I32, 0}, {"js_str", sim::ColType::I32, 0}, {"js_rot", sim::ColType::I32, 0},
+  });
+  if (!log.ok()) { std::perror(path); return 1; }
+  sim::run_plan(sim::default_plan(), cfg, sim::Perturb{}, 0, [&](const sim::Sample& s) {
+    log.push({s.t, s.gt.x, s.gt.y, s.gt.theta, s.est.x, s.est.y, s.est.theta,
+              s.df, s.ds, s.dr, s.sPar, s.sPerp, s.imu_heading,
+              (double)s.fwd, (double)s.str, (double)s.rot});
+  });
+
   return 0;
 }
 #endif
\ No newline at end of file
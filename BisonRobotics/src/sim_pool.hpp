@@ -0,0 +1,126 @@
+#pragma once
+
+#ifdef SIM
+// Work-stealing thread pool for the host batch tools.
+// parallel_for() splits [0,n) into one contiguous range per worker. A worker
+// takes `grain` indices at a time from the front of its own range; when it runs
+// dry it steals the back half of the fullest other range. Trials cost very
+// different amounts of time, so this keeps every core busy to the end.
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sim {
+
+class WorkPool {
+ public:
+  explicit WorkPool(unsigned threads = 0) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    slots_.reset(new Slot[threads]);
+    for (unsigned i = 0; i < threads; ++i)
+      workers_.emplace_back([this, i]{ worker(i); });
+  }
+  ~WorkPool() {
+    { std::lock_guard<std::mutex> lk(m_); stop_ = true; }
+    start_cv_.notify_all();
+    for (auto& w : workers_) w.join();
+  }
+  WorkPool(const WorkPool&) = delete;
+  WorkPool& operator=(const WorkPool&) = delete;
+
+  unsigned size() const { return (unsigned)workers_.size(); }
+
+  // Runs fn(i) for every i in [0,n) and blocks until all calls returned.
+  // fn(i) is called on a pool thread; never from the caller.
+  void parallel_for(size_t n, std::function<void(size_t)> fn, size_t grain = 1) {
+    if (n == 0) return;
+    const size_t W = workers_.size();
+    std::unique_lock<std::mutex> lk(m_);
+    job_ = std::move(fn);
+    grain_ = std::max<size_t>(1, grain);
+    for (size_t i = 0; i < W; ++i) {
+      std::lock_guard<std::mutex> sl(slots_[i].m);
+      slots_[i].begin = n * i / W;
+      slots_[i].end   = n * (i + 1) / W;
+    }
+    active_ = W;
+    ++gen_;
+    start_cv_.notify_all();
+    done_cv_.wait(lk, [this]{ return active_ == 0; });
+    job_ = nullptr;
+  }
+
+ private:
+  struct alignas(64) Slot { std::mutex m; size_t begin = 0, end = 0; };
+
+  // Pop up to `grain_` indices from the front of our own range.
+  bool take_own(size_t self, size_t& b, size_t& e) {
+    Slot& s = slots_[self];
+    std::lock_guard<std::mutex> lk(s.m);
+    if (s.begin >= s.end) return false;
+    b = s.begin; e = std::min(s.end, s.begin + grain_); s.begin = e;
+    return true;
+  }
+
+  // Move the back half of the largest other range into our own slot.
+  bool steal(size_t self) {
+    const size_t W = workers_.size();
+    size_t victim = W, best = 0;
+    for (size_t k = 1; k < W; ++k) {
+      const size_t v = (self + k) % W;
+      std::lock_guard<std::mutex> lk(slots_[v].m);
+      const size_t left = slots_[v].end - slots_[v].begin;
+      if (left > best) { best = left; victim = v; }
+    }
+    if (victim == W) return false;
+    size_t b, e;
+    {
+      Slot& v = slots_[victim];
+      std::lock_guard<std::mutex> lk(v.m);
+      if (v.begin >= v.end) return true;       // raced; caller retries
+      const size_t mid = v.begin + (v.end - v.begin) / 2;
+      b = mid; e = v.end; v.end = mid;
+    }
+    Slot& s = slots_[self];
+    std::lock_guard<std::mutex> lk(s.m);
+    s.begin = b; s.end = e;
+    return true;
+  }
+
+  void worker(size_t self) {
+    uint64_t seen = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lk(m_);
+        start_cv_.wait(lk, [&]{ return stop_ || gen_ != seen; });
+        if (stop_) return;
+        seen = gen_;
+      }
+      size_t b, e;
+      for (;;) {
+        if (take_own(self, b, e)) { for (size_t i = b; i < e; ++i) job_(i); continue; }
+        if (!steal(self)) break;
+      }
+      std::lock_guard<std::mutex> lk(m_);
+      if (--active_ == 0) done_cv_.notify_all();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::unique_ptr<Slot[]> slots_;
+  std::mutex m_;
+  std::condition_variable start_cv_, done_cv_;
+  std::function<void(size_t)> job_;
+  size_t grain_ = 1, active_ = 0;
+  uint64_t gen_ = 0;
+  bool stop_ = false;
+};
+
+} // namespace sim
+#endif
@@ -0,0 +1,395 @@
+#ifdef SIM
+#include "sim_compat.hpp"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <ucontext.h>
+#endif
+
+namespace {
+
+// Host stack per task. Target stack_depth is in 4-byte words and far too small
+// for host printf/libstdc++ frames, so it is only used as a lower bound.
+constexpr size_t HOST_STACK_BYTES = 256 * 1024;
+
+enum class State { Ready, Running, Delayed, Notify, Join, Suspended, Deleted };
+
+struct Tcb {
+  uint32_t id;
+  std::string name;
+  uint32_t prio;
+  pros::task_fn_t fn;
+  void* arg;
+  State state = State::Ready;
+  uint64_t ready_seq = 0;
+  uint64_t wake_us = 0;     // for Delayed, and Notify/Join with a timeout
+  bool timed = false;
+  uint32_t notify_value = 0;
+  bool notify_pending = false;
+  Tcb* join_target = nullptr;
+#ifdef _WIN32
+  LPVOID fiber = nullptr;
+#else
+  ucontext_t ctx;
+  std::unique_ptr<char[]> stack;
+#endif
+};
+
+struct Scheduler {
+  std::vector<std::unique_ptr<Tcb>> tasks;
+  Tcb* current = nullptr;
+  uint64_t seq = 0;
+  uint32_t next_id = 1;
+  uint32_t suspended = 0;   // rtos_suspend_all() depth
+  bool running = false;
+#ifdef _WIN32
+  LPVOID main_fiber = nullptr;
+#else
+  ucontext_t main_ctx;
+#endif
+};
+
+thread_local Scheduler sched;
+
+void make_ready(Tcb* t) { t->state = State::Ready; t->timed = false; t->ready_seq = ++sched.seq; }
+
+bool alive(const Tcb* t) { return t && t->state != State::Deleted; }
+
+// Switch from the running task back to the scheduler loop.
+void yield_to_scheduler() {
+  Tcb* t = sched.current;
+#ifdef _WIN32
+  SwitchToFiber(sched.main_fiber);
+#else
+  swapcontext(&t->ctx, &sched.main_ctx);
+#endif
+  (void)t;
+}
+
+void finish(Tcb* t) {
+  t->state = State::Deleted;
+  for (auto& o : sched.tasks)
+    if (o->state == State::Join && o->join_target == t) make_ready(o.get());
+}
+
+#ifdef _WIN32
+void CALLBACK trampoline(LPVOID p) {
+  Tcb* t = static_cast<Tcb*>(p);
+  t->fn(t->arg);
+  finish(t);
+  yield_to_scheduler();
+}
+#else
+void trampoline() {
+  Tcb* t = sched.current;
+  t->fn(t->arg);
+  finish(t);
+  yield_to_scheduler();
+}
+#endif
+
+void switch_to(Tcb* t) {
+  sched.current = t;
+  t->state = State::Running;
+#ifdef _WIN32
+  SwitchToFiber(t->fiber);
+#else
+  swapcontext(&sched.main_ctx, &t->ctx);
+#endif
+  sched.current = nullptr;
+  if (t->state == State::Running) make_ready(t);  // preempted by a wakeup
+}
+
+void free_stack(Tcb* t) {
+#ifdef _WIN32
+  if (t->fiber) { DeleteFiber(t->fiber); t->fiber = nullptr; }
+#else
+  t->stack.reset();
+#endif
+}
+
+// Highest priority first, then first-ready first.
+Tcb* pick() {
+  Tcb* best = nullptr;
+  for (auto& t : sched.tasks) {
+    if (t->state != State::Ready) continue;
+    if (!best || t->prio > best->prio || (t->prio == best->prio && t->ready_seq < best->ready_seq))
+      best = t.get();
+  }
+  return best;
+}
+
+bool waiting_on_time(const Tcb* t) {
+  return t->state == State::Delayed ||
+         ((t->state == State::Notify || t->state == State::Join) && t->timed);
+}
+
+// Ready every task whose wake time has passed, earliest deadline first.
+void wake_due(uint64_t now) {
+  std::vector<Tcb*> due;
+  for (auto& t : sched.tasks)
+    if (waiting_on_time(t.get()) && t->wake_us <= now) due.push_back(t.get());
+  std::sort(due.begin(), due.end(), [](Tcb* a, Tcb* b) {
+    return a->wake_us != b->wake_us ? a->wake_us < b->wake_us : a->id < b->id;
+  });
+  for (Tcb* t : due) make_ready(t);
+}
+
+void block_current_until(State s, uint64_t wake_us, bool timed) {
+  Tcb* t = sched.current;
+  t->state = s; t->wake_us = wake_us; t->timed = timed;
+  yield_to_scheduler();
+}
+
+// A task made `t` ready: switch to it now if it outranks the caller.
+void maybe_preempt(Tcb* t) {
+  Tcb* cur = sched.current;
+  if (cur && !sched.suspended && t->state == State::Ready && t->prio > cur->prio) {
+    make_ready(cur);
+    yield_to_scheduler();
+  }
+}
+
+// Runs from sleep_ms(): block the task, or drive the scheduler from the host.
+void sleep_hook(uint64_t us) {
+  if (sched.current) block_current_until(State::Delayed, sim::now_us() + us, true);
+  else sim::run_tasks_until(sim::now_us() + us);
+}
+
+Tcb* create(pros::task_fn_t fn, void* arg, uint32_t prio, uint16_t depth, const char* name) {
+  sim::clock().sleep_hook = sleep_hook;
+  auto t = std::make_unique<Tcb>();
+  t->id = sched.next_id++;
+  t->name = name ? name : "";
+  t->prio = std::max<uint32_t>(TASK_PRIORITY_MIN, std::min<uint32_t>(TASK_PRIORITY_MAX, prio));
+  t->fn = fn; t->arg = arg;
+  const size_t bytes = std::max(HOST_STACK_BYTES, (size_t)depth * 4);
+#ifdef _WIN32
+  if (!sched.main_fiber) sched.main_fiber = ConvertThreadToFiber(nullptr);
+  t->fiber = CreateFiber(bytes, trampoline, t.get());
+#else
+  t->stack.reset(new char[bytes]);
+  getcontext(&t->ctx);
+  t->ctx.uc_stack.ss_sp = t->stack.get();
+  t->ctx.uc_stack.ss_size = bytes;
+  t->ctx.uc_link = nullptr;
+  makecontext(&t->ctx, trampoline, 0);
+#endif
+  make_ready(t.get());
+  Tcb* raw = t.get();
+  sched.tasks.push_back(std::move(t));
+  return raw;
+}
+
+Tcb* tcb(pros::task_t t) { return static_cast<Tcb*>(t); }
+
+} // namespace
+
+// ---- sim driver API ----
+namespace sim {
+
+void run_tasks_until(uint64_t until_us) {
+  if (sched.running) return;  // called from inside a task; sleep_hook handles that
+  sched.running = true;
+  for (;;) {
+    wake_due(now_us());
+    if (Tcb* t = pick()) {
+      switch_to(t);
+      if (t->state == State::Deleted) free_stack(t);
+      continue;
+    }
+    uint64_t next = UINT64_MAX;
+    for (auto& t : sched.tasks)
+      if (waiting_on_time(t.get())) next = std::min(next, t->wake_us);
+    if (next > until_us) break;
+    if (next > now_us()) advance_us(next - now_us());
+  }
+  if (now_us() < until_us) advance_us(until_us - now_us());
+  sched.running = false;
+}
+
+// Process-wide and function-local, so other files can register during static
+// initialization; each hook resets the killing thread's own state.
+struct KillHooks { void (*fn[8])(); size_t n = 0; };
+static KillHooks& kill_hooks() { static KillHooks h; return h; }
+
+void on_kill_all_tasks(void (*fn)()) {
+  KillHooks& h = kill_hooks();
+  if (h.n < 8) h.fn[h.n++] = fn;
+}
+
+void kill_all_tasks() {
+  for (auto& t : sched.tasks) free_stack(t.get());
+  sched.tasks.clear();
+  const KillHooks& h = kill_hooks();
+  for (size_t i = 0; i < h.n; ++i) h.fn[i]();
+}
+
+ControllerState& controller() { static thread_local ControllerState c; return c; }
+
+static thread_local char lcd_lines[8][64];
+static thread_local bool lcd_ready = false;
+
+const char* lcd_line(int line) { return (line >= 0 && line < 8) ? lcd_lines[line] : ""; }
+
+} // namespace sim
+
+// ---- pros:: emulation ----
+void rtos_suspend_all() { ++sched.suspended; }
+std::int32_t rtos_resume_all() {
+  if (!sched.suspended || --sched.suspended) return 0;
+  Tcb* cur = sched.current;
+  Tcb* t = pick();
+  if (!cur || !t || t->prio <= cur->prio) return 0;
+  make_ready(cur);  // a wakeup inside the lock outranks us
+  yield_to_scheduler();
+  return 1;
+}
+
+namespace pros {
+
+std::uint32_t millis() { return now_ms(); }
+std::uint64_t micros() { return sim::now_us(); }
+void delay(std::uint32_t ms) { sleep_hook((uint64_t)ms * 1000); }
+
+Task::Task(task_fn_t function, void* parameters, std::uint32_t prio, std::uint16_t stack_depth,
+           const char* name)
+    : task(create(function, parameters, prio, stack_depth, name)) {
+  maybe_preempt(tcb(task));
+}
+Task::Task(task_fn_t function, void* parameters, const char* name)
+    : Task(function, parameters, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, name) {}
+
+Task Task::current() { return Task(static_cast<task_t>(sched.current)); }
+
+void Task::remove() {
+  Tcb* t = tcb(task);
+  if (!alive(t)) return;
+  finish(t);
+  if (t == sched.current) yield_to_scheduler();  // never resumes
+}
+
+std::uint32_t Task::get_priority() { return tcb(task) ? tcb(task)->prio : 0; }
+void Task::set_priority(std::uint32_t prio) {
+  if (tcb(task)) tcb(task)->prio = std::max<uint32_t>(TASK_PRIORITY_MIN, std::min<uint32_t>(TASK_PRIORITY_MAX, prio));
+}
+
+std::uint32_t Task::get_state() {
+  const Tcb* t = tcb(task);
+  if (!t) return E_TASK_STATE_INVALID;
+  switch (t->state) {
+    case State::Running:   return E_TASK_STATE_RUNNING;
+    case State::Ready:     return E_TASK_STATE_READY;
+    case State::Suspended: return E_TASK_STATE_SUSPENDED;
+    case State::Deleted:   return E_TASK_STATE_DELETED;
+    default:               return E_TASK_STATE_BLOCKED;
+  }
+}
+
+void Task::suspend() {
+  Tcb* t = tcb(task);
+  if (!alive(t)) return;
+  t->state = State::Suspended;
+  if (t == sched.current) yield_to_scheduler();
+}
+void Task::resume() {
+  Tcb* t = tcb(task);
+  if (t && t->state == State::Suspended) { make_ready(t); maybe_preempt(t); }
+}
+
+const char* Task::get_name() { return tcb(task) ? tcb(task)->name.c_str() : ""; }
+
+std::uint32_t Task::notify() { return notify_ext(0, E_NOTIFY_ACTION_INCR, nullptr); }
+
+std::uint32_t Task::notify_ext(std::uint32_t value, notify_action_e_t action, std::uint32_t* prev_value) {
+  Tcb* t = tcb(task);
+  if (!alive(t)) return 0;
+  if (prev_value) *prev_value = t->notify_value;
+  switch (action) {
+    case E_NOTIFY_ACTION_NONE:   break;
+    case E_NOTIFY_ACTION_BITS:   t->notify_value |= value; break;
+    case E_NOTIFY_ACTION_INCR:   ++t->notify_value; break;
+    case E_NOTIFY_ACTION_OWRITE: t->notify_value = value; break;
+    case E_NOTIFY_ACTION_NO_OWRITE:
+      if (t->notify_pending) return 0;
+      t->notify_value = value; break;
+  }
+  t->notify_pending = true;
+  if (t->state == State::Notify) { make_ready(t); maybe_preempt(t); }
+  return 1;
+}
+
+std::uint32_t Task::notify_take(bool clear_on_exit, std::uint32_t timeout) {
+  Tcb* t = sched.current;
+  if (!t) return 0;
+  if (t->notify_value == 0 && timeout > 0)
+    block_current_until(State::Notify, sim::now_us() + (uint64_t)timeout * 1000, timeout != TIMEOUT_MAX);
+  const std::uint32_t v = t->notify_value;
+  if (v) t->notify_value = clear_on_exit ? 0 : v - 1;
+  t->notify_pending = false;
+  return v;
+}
+
+bool Task::notify_clear() {
+  Tcb* t = tcb(task);
+  if (!t) return false;
+  const bool was = t->notify_pending;
+  t->notify_pending = false;
+  return was;
+}
+
+void Task::join() {
+  Tcb* t = tcb(task);
+  if (!alive(t) || t == sched.current) return;
+  if (sched.current) {
+    sched.current->join_target = t;
+    block_current_until(State::Join, 0, false);
+  } else {
+    while (alive(t)) sim::run_tasks_for(1);
+  }
+}
+
+void Task::delay(const std::uint32_t milliseconds) { pros::delay(milliseconds); }
+
+void Task::delay_until(std::uint32_t* const prev_time, const std::uint32_t delta) {
+  *prev_time += delta;
+  const uint64_t wake = (uint64_t)*prev_time * 1000;
+  const uint64_t now = sim::now_us();
+  if (wake > now) sleep_hook(wake - now);
+}
+
+std::uint32_t Task::get_count() {
+  return (std::uint32_t)std::count_if(sched.tasks.begin(), sched.tasks.end(),
+                                      [](const auto& t) { return alive(t.get()); });
+}
+
+std::int32_t Controller::get_analog(controller_analog_e_t channel) {
+  return sim::controller().analog[id][channel];
+}
+std::int32_t Controller::get_digital(controller_digital_e_t button) {
+  return sim::controller().digital[id][button] ? 1 : 0;
+}
+
+namespace lcd {
+bool initialize() { sim::lcd_ready = true; return true; }
+bool is_initialized() { return sim::lcd_ready; }
+bool print(std::int16_t line, const char* fmt, ...) {
+  if (line < 0 || line >= 8) return false;
+  va_list args;
+  va_start(args, fmt);
+  std::vsnprintf(sim::lcd_lines[line], sizeof sim::lcd_lines[line], fmt, args);
+  va_end(args);
+  return true;
+}
+bool set_text(std::int16_t line, std::string text) { return print(line, "%s", text.c_str()); }
+bool clear_line(std::int16_t line) { return print(line, "%s", ""); }
+bool clear() { for (int i = 0; i < 8; ++i) clear_line(i); return true; }
+} // namespace lcd
+
+} // namespace pros
+#endif
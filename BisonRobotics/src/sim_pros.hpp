@@ -0,0 +1,185 @@
+#pragma once
+
+#ifdef SIM
+// ---- PROS API emulation for SIM builds ----
+// Just enough of pros::Task, pros::delay/millis/micros, pros::Controller and
+// pros::lcd for main.cpp and xdrive.cpp to build and run unmodified on a host.
+//
+// Tasks are cooperative and all run on the calling host thread (ucontext, or
+// fibers on Windows). A task only gives up the CPU in delay(), delay_until(),
+// notify_take(), join(), suspend() or by returning; notify()/resume()/creating
+// a higher-priority task switches to it immediately, like the RTOS would.
+// The scheduler always runs the highest-priority ready task, equal priorities
+// in the order they became ready, and advances the virtual clock from
+// sim_compat.hpp when every task is blocked. The same inputs therefore give
+// bit-identical runs, at whatever speed the clock mode allows.
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#define TASK_PRIORITY_MAX 16
+#define TASK_PRIORITY_MIN 1
+#define TASK_PRIORITY_DEFAULT 8
+#define TASK_STACK_DEPTH_DEFAULT 0x2000
+#define TASK_STACK_DEPTH_MIN 0x200
+#define TIMEOUT_MAX ((uint32_t)0xffffffffUL)
+
+extern "C" {
+void autonomous(void);
+void initialize(void);
+void disabled(void);
+void competition_initialize(void);
+void opcontrol(void);
+}
+
+// Scheduler lock, global like the PROS kernel's (FreeRTOS vTaskSuspendAll):
+// wakeups inside it make tasks ready but switch only at the outermost resume.
+void rtos_suspend_all();
+std::int32_t rtos_resume_all();
+
+namespace pros {
+
+typedef void* task_t;
+typedef void (*task_fn_t)(void*);
+
+typedef enum {
+  E_TASK_STATE_RUNNING = 0,
+  E_TASK_STATE_READY,
+  E_TASK_STATE_BLOCKED,
+  E_TASK_STATE_SUSPENDED,
+  E_TASK_STATE_DELETED,
+  E_TASK_STATE_INVALID
+} task_state_e_t;
+
+typedef enum {
+  E_NOTIFY_ACTION_NONE,
+  E_NOTIFY_ACTION_BITS,
+  E_NOTIFY_ACTION_INCR,
+  E_NOTIFY_ACTION_OWRITE,
+  E_NOTIFY_ACTION_NO_OWRITE
+} notify_action_e_t;
+
+std::uint32_t millis();
+std::uint64_t micros();
+void delay(std::uint32_t milliseconds);
+
+class Task {
+ public:
+  Task(task_fn_t function, void* parameters = nullptr, std::uint32_t prio = TASK_PRIORITY_DEFAULT,
+       std::uint16_t stack_depth = TASK_STACK_DEPTH_DEFAULT, const char* name = "");
+  Task(task_fn_t function, void* parameters, const char* name);
+
+  template <class F>
+  explicit Task(F&& function, std::uint32_t prio = TASK_PRIORITY_DEFAULT,
+                std::uint16_t stack_depth = TASK_STACK_DEPTH_DEFAULT, const char* name = "")
+      : Task(
+            [](void* parameters) {
+              std::unique_ptr<std::function<void()>> ptr{static_cast<std::function<void()>*>(parameters)};
+              (*ptr)();
+            },
+            new std::function<void()>(std::forward<F>(function)), prio, stack_depth, name) {
+    static_assert(std::is_invocable_r_v<void, F>);
+  }
+  template <class F>
+  Task(F&& function, const char* name)
+      : Task(std::forward<F>(function), TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, name) {}
+
+  explicit Task(task_t task): task(task) {}
+
+  static Task current();
+  void remove();
+  std::uint32_t get_priority();
+  void set_priority(std::uint32_t prio);
+  std::uint32_t get_state();
+  void suspend();
+  void resume();
+  const char* get_name();
+  explicit operator task_t() { return task; }
+
+  std::uint32_t notify();
+  void join();
+  std::uint32_t notify_ext(std::uint32_t value, notify_action_e_t action, std::uint32_t* prev_value);
+  static std::uint32_t notify_take(bool clear_on_exit, std::uint32_t timeout);
+  bool notify_clear();
+
+  static void delay(const std::uint32_t milliseconds);
+  static void delay_until(std::uint32_t* const prev_time, const std::uint32_t delta);
+  static std::uint32_t get_count();
+
+ private:
+  task_t task;
+};
+
+typedef enum { E_CONTROLLER_MASTER = 0, E_CONTROLLER_PARTNER } controller_id_e_t;
+
+typedef enum {
+  E_CONTROLLER_ANALOG_LEFT_X = 0,
+  E_CONTROLLER_ANALOG_LEFT_Y,
+  E_CONTROLLER_ANALOG_RIGHT_X,
+  E_CONTROLLER_ANALOG_RIGHT_Y
+} controller_analog_e_t;
+
+typedef enum {
+  E_CONTROLLER_DIGITAL_L1 = 6,
+  E_CONTROLLER_DIGITAL_L2,
+  E_CONTROLLER_DIGITAL_R1,
+  E_CONTROLLER_DIGITAL_R2,
+  E_CONTROLLER_DIGITAL_UP,
+  E_CONTROLLER_DIGITAL_DOWN,
+  E_CONTROLLER_DIGITAL_LEFT,
+  E_CONTROLLER_DIGITAL_RIGHT,
+  E_CONTROLLER_DIGITAL_X,
+  E_CONTROLLER_DIGITAL_B,
+  E_CONTROLLER_DIGITAL_Y,
+  E_CONTROLLER_DIGITAL_A,
+  E_CONTROLLER_DIGITAL_POWER
+} controller_digital_e_t;
+
+// Reads the sticks/buttons the harness writes into sim::controller().
+class Controller {
+ public:
+  explicit Controller(controller_id_e_t id): id(id) {}
+  std::int32_t get_analog(controller_analog_e_t channel);
+  std::int32_t get_digital(controller_digital_e_t button);
+ private:
+  controller_id_e_t id;
+};
+
+// LLEMU text lines are kept in memory; see sim::lcd_line().
+namespace lcd {
+bool initialize();
+bool is_initialized();
+bool print(std::int16_t line, const char* fmt, ...);
+bool set_text(std::int16_t line, std::string text);
+bool clear_line(std::int16_t line);
+bool clear();
+} // namespace lcd
+
+} // namespace pros
+
+namespace sim {
+
+// Run tasks until the virtual clock reaches `until_us`. Returns early only if
+// no task exists at all. Calling pros::delay() from the host thread (outside
+// any task) does the same for the delay length.
+void run_tasks_until(uint64_t until_us);
+inline void run_tasks_for(uint32_t ms) { run_tasks_until(now_us() + (uint64_t)ms * 1000); }
+
+// Delete every task (stacks are freed; objects on them are not destroyed),
+// then run the on_kill_all_tasks() hooks so modules that keep task handles
+// (control loops, the motion task, the logger) drop them.
+void kill_all_tasks();
+void on_kill_all_tasks(void (*fn)());  // up to 8, e.g. from a static initializer
+
+struct ControllerState {
+  int32_t analog[2][4] = {};   // [controller][channel], -127..127
+  bool    digital[2][19] = {}; // indexed by controller_digital_e_t
+};
+ControllerState& controller();
+
+const char* lcd_line(int line);  // 0..7
+
+} // namespace sim
+#endif
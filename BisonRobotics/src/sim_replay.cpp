@@ -0,0 +1,286 @@
+#ifdef SIM
+// Log replay / offline tuning.
+// Feeds a recorded run back through the robot code as fast as the CPU allows,
+// once per candidate configuration, and ranks the candidates by error against
+// the recorded ground truth:
+//   odometry : tracking wheel + IMU channels into Odom2WIMU (update_batch)
+//              for every L_par x L_perp pair
+//   drive    : recorded sticks through xdrive::drive() (velocity control on
+//              the SIM motor model) and the sim plant for every
+//              DEADBAND x SQUARE_INPUTS pair
+// Input is a .brlg from `sim` or any CSV with the same column names. Logs
+// without s_par/s_perp/imu_th (e.g. odom_log.csv) get tracking wheel readings
+// synthesized from ground truth for the wheel offsets given by --rec-lpar /
+// --rec-lperp; logs without js_* columns skip the drive replay.
+//
+// Build: g++ -DSIM -O2 -std=gnu++17 -Iinclude -pthread -o sim_replay src/sim_replay.cpp
+//          src/xdrive.cpp src/control.cpp src/sim_pros.cpp
+// Usage: sim_replay log.{brlg,csv} [--lpar list] [--lperp list] [--deadband list]
+//                   [--square list] [--rec-lpar in] [--rec-lperp in] [--top n] [-j threads]
+//   a list is comma-separated values and/or lo:hi:step ranges, e.g. 2,2.5:4:0.25
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "xdrive.hpp"
+#include "odom.hpp"
+#include "sim_compat.hpp"
+#include "sim_trial.hpp"
+#include "sim_pool.hpp"
+#include "sim_log.hpp"
+
+// ---- Recorded channels (structure of arrays) ----
+struct Recording {
+  std::vector<double> t, gx, gy, gth;   // ground truth
+  std::vector<double> sPar, sPerp, imu; // odometry inputs
+  std::vector<int> fwd, str, rot;       // sticks
+  bool sensors = false, sticks = false;
+  size_t size() const { return t.size(); }
+};
+
+static bool has(const std::vector<std::string>& names, const char* n) {
+  return std::find(names.begin(), names.end(), n) != names.end();
+}
+
+// Copy the named columns of a .brlg or CSV log into `rec`.
+static bool load(const char* path, Recording& rec) {
+  std::vector<std::string> names;
+  std::vector<std::vector<double>> cols;
+
+  const size_t len = std::strlen(path);
+  if (len > 5 && !std::strcmp(path + len - 5, ".brlg")) {
+    sim::LogReader log(path);
+    if (!log.ok()) return false;
+    for (size_t c = 0; c < log.columns().size(); ++c) {
+      names.push_back(log.columns()[c].name);
+      cols.push_back(log.column(c));
+    }
+  } else {
+    std::FILE* f = std::fopen(path, "r");
+    if (!f) return false;
+    static char line[1 << 14];
+    if (!std::fgets(line, sizeof line, f)) { std::fclose(f); return false; }
+    for (char* tok = std::strtok(line, ",\r\n"); tok; tok = std::strtok(nullptr, ",\r\n")) {
+      while (*tok == ' ') ++tok;
+      names.emplace_back(tok);
+    }
+    cols.resize(names.size());
+    while (std::fgets(line, sizeof line, f)) {
+      char* p = line;
+      for (auto& col : cols) {
+        char* end;
+        col.push_back(std::strtod(p, &end));
+        p = end + (*end == ',');
+      }
+    }
+    std::fclose(f);
+  }
+
+  auto get = [&](const char* n, std::vector<double>& out) {
+    const auto it = std::find(names.begin(), names.end(), n);
+    if (it != names.end()) out = std::move(cols[it - names.begin()]);
+  };
+  auto get_int = [&](const char* n, std::vector<int>& out) {
+    std::vector<double> v; get(n, v);
+    out.assign(v.begin(), v.end());
+  };
+  for (const char* n : {"time_s", "gt_x", "gt_y", "gt_th"})
+    if (!has(names, n)) { std::fprintf(stderr, "%s: missing column %s\n", path, n); return false; }
+  get("time_s", rec.t); get("gt_x", rec.gx); get("gt_y", rec.gy); get("gt_th", rec.gth);
+  rec.sensors = has(names, "s_par") && has(names, "s_perp") && has(names, "imu_th");
+  if (rec.sensors) { get("s_par", rec.sPar); get("s_perp", rec.sPerp); get("imu_th", rec.imu); }
+  rec.sticks = has(names, "js_fwd") && has(names, "js_str") && has(names, "js_rot");
+  if (rec.sticks) { get_int("js_fwd", rec.fwd); get_int("js_str", rec.str); get_int("js_rot", rec.rot); }
+  return rec.size() > 1;
+}
+
+// Tracking wheel / IMU readings an ideal robot with wheel offsets
+// (L_par, L_perp) would have produced along the ground-truth path.
+static void synthesize_sensors(Recording& rec, double L_par, double L_perp) {
+  const size_t n = rec.size();
+  rec.sPar.assign(n, 0.0); rec.sPerp.assign(n, 0.0); rec.imu = rec.gth;
+  for (size_t i = 1; i < n; ++i) {
+    const double dth = Odom2WIMU::wrap(rec.gth[i] - rec.gth[i-1]);
+    const double thm = rec.gth[i-1] + 0.5*dth;
+    const double c = std::cos(thm), s = std::sin(thm);
+    const double dxf = rec.gx[i] - rec.gx[i-1], dyf = rec.gy[i] - rec.gy[i-1];
+    const double dx_r =  c*dxf + s*dyf;   // +right
+    const double dy_r = -s*dxf + c*dyf;   // +forward
+    rec.sPerp[i] = dx_r + L_perp * dth;
+    rec.sPar[i]  = dy_r - L_par  * dth;
+  }
+}
+
+// ---- Error against ground truth ----
+struct Score {
+  double rms = 0, max = 0, final_pos = 0, final_deg = 0;
+  void add(double ex, double ey) { const double e = std::hypot(ex, ey); rms += e*e; max = std::max(max, e); }
+  void finish(size_t n, double ex, double ey, double eth) {
+    rms = std::sqrt(rms / n);
+    final_pos = std::hypot(ex, ey);
+    final_deg = std::abs(Odom2WIMU::wrap(eth)) * 180.0 / M_PI;
+  }
+};
+
+// Row 0 is the start pose; rows 1.. are replayed.
+static Score replay_odom(const Recording& rec, double L_par, double L_perp) {
+  OdomConfig cfg; cfg.L_par = L_par; cfg.L_perp = L_perp;
+  cfg.start = {rec.gx[0], rec.gy[0], rec.gth[0]};
+  Odom2WIMU odom(cfg);
+  double x[odom_batch::BLOCK], y[odom_batch::BLOCK], th[odom_batch::BLOCK];
+  Score sc;
+  const size_t n = rec.size();
+  for (size_t i = 1; i < n; i += odom_batch::BLOCK) {
+    const size_t m = std::min(odom_batch::BLOCK, n - i);
+    odom.update_batch(&rec.sPar[i], &rec.sPerp[i], &rec.imu[i], m, x, y, th);
+    for (size_t k = 0; k < m; ++k) sc.add(x[k] - rec.gx[i+k], y[k] - rec.gy[i+k]);
+  }
+  const Pose p = odom.pose();
+  sc.finish(n - 1, p.x - rec.gx[n-1], p.y - rec.gy[n-1], p.theta - rec.gth[n-1]);
+  return sc;
+}
+
+// Runs drive() itself on this pool thread's motor mocks, so the replay takes
+// the same velocity-control path (wheel_mv, move_voltage, the motor model's
+// duty) as the recorded run. Rows are 10 ms control ticks; row i's sticks
+// drove the tick that ended at row i.
+static Pose replay_ticks(const Recording& rec, const xdrive::Shaping& sh, const sim::PlantParams& pp,
+                         const Pose& start, size_t rows, Score* sc) {
+  sim::set_clock_mode(sim::ClockMode::Fast);
+  sim::reset_clock();
+  xdrive::initialize();
+  sim::Plant plant(start, pp);
+  const uint32_t dt_ms = (uint32_t)std::lround(pp.dt * 1000.0);
+  for (size_t i = 0; i < rows; ++i) {
+    xdrive::drive(rec.fwd[i], rec.str[i], rec.rot[i], false, sh);
+    sleep_ms(dt_ms);
+    plant.advance_to(sim::now_us());
+    const Pose& p = plant.pose();
+    if (sc && i > 0) sc->add(p.x - rec.gx[i], p.y - rec.gy[i]);
+  }
+  xdrive::drive(0, 0, 0);
+  return plant.pose();
+}
+
+static Score replay_drive(const Recording& rec, const xdrive::Shaping& sh,
+                          const sim::PlantParams& pp) {
+  // The robot was at rest before row 0 and row 0 holds the pose after its
+  // first tick: find where it started by replaying that tick once.
+  const Pose g0{rec.gx[0], rec.gy[0], rec.gth[0]};
+  const Pose p0 = replay_ticks(rec, sh, pp, g0, 1, nullptr);
+  const Pose start{2 * g0.x - p0.x, 2 * g0.y - p0.y, Odom2WIMU::wrap(2 * g0.theta - p0.theta)};
+
+  Score sc;
+  const size_t n = rec.size();
+  const Pose p = replay_ticks(rec, sh, pp, start, n, &sc);
+  sc.finish(n - 1, p.x - rec.gx[n-1], p.y - rec.gy[n-1], p.theta - rec.gth[n-1]);
+  return sc;
+}
+
+// "2,2.5:4:0.25" -> {2, 2.5, 2.75, ..., 4}
+static std::vector<double> parse_list(const char* s) {
+  std::vector<double> out;
+  std::string str(s);
+  size_t pos = 0;
+  while (pos <= str.size()) {
+    const size_t comma = std::min(str.find(',', pos), str.size());
+    const std::string item = str.substr(pos, comma - pos);
+    double lo, hi, st;
+    if (std::sscanf(item.c_str(), "%lf:%lf:%lf", &lo, &hi, &st) == 3 && st > 0.0)
+      for (int k = 0; lo + k * st <= hi + 1e-9; ++k) out.push_back(lo + k * st);
+    else if (!item.empty())
+      out.push_back(std::atof(item.c_str()));
+    pos = comma + 1;
+  }
+  return out;
+}
+
+template <class Cand>
+static void print_ranked(const char* title, std::vector<std::pair<Cand, Score>>& rows, size_t top,
+                         void (*label)(const Cand&, char*, size_t)) {
+  std::sort(rows.begin(), rows.end(),
+            [](const auto& a, const auto& b){ return a.second.rms < b.second.rms; });
+  std::printf("\n%-24s %10s %10s %10s %10s\n", title, "rms (in)", "max (in)", "final (in)", "final (deg)");
+  for (size_t k = 0; k < std::min(top, rows.size()); ++k) {
+    char buf[64];
+    label(rows[k].first, buf, sizeof buf);
+    const Score& s = rows[k].second;
+    std::printf("%-24s %10.4f %10.4f %10.4f %10.4f\n", buf, s.rms, s.max, s.final_pos, s.final_deg);
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argv[1][0] == '-') {
+    std::fprintf(stderr, "usage: %s log.{brlg,csv} [--lpar list] [--lperp list] [--deadband list]\n"
+                         "       [--square list] [--rec-lpar in] [--rec-lperp in] [--top n] [-j threads]\n",
+                 argv[0]);
+    return 2;
+  }
+  std::vector<double> lpar = parse_list("2:4:0.25"), lperp = parse_list("3:5:0.25");
+  std::vector<double> deadbands = {(double)xdrive::DEADBAND}, squares = {0, 1};
+  double rec_lpar = 3.0, rec_lperp = 4.0;
+  size_t top = 10;
+  unsigned threads = 0;
+
+  for (int i = 2; i < argc; ++i) {
+    auto arg = [&](const char* name){ return !std::strcmp(argv[i], name) && i + 1 < argc; };
+    if      (arg("--lpar"))      lpar      = parse_list(argv[++i]);
+    else if (arg("--lperp"))     lperp     = parse_list(argv[++i]);
+    else if (arg("--deadband"))  deadbands = parse_list(argv[++i]);
+    else if (arg("--square"))    squares   = parse_list(argv[++i]);
+    else if (arg("--rec-lpar"))  rec_lpar  = std::atof(argv[++i]);
+    else if (arg("--rec-lperp")) rec_lperp = std::atof(argv[++i]);
+    else if (arg("--top"))       top       = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg("-j"))          threads   = std::atoi(argv[++i]);
+    else { std::fprintf(stderr, "unknown argument: %s\n", argv[i]); return 2; }
+  }
+
+  Recording rec;
+  if (!load(argv[1], rec)) { std::fprintf(stderr, "%s: not a readable log\n", argv[1]); return 1; }
+  if (!rec.sensors) {
+    synthesize_sensors(rec, rec_lpar, rec_lperp);
+    std::printf("no sensor channels: synthesized for L_par %.3f L_perp %.3f\n", rec_lpar, rec_lperp);
+  }
+  std::printf("%s: %zu samples, %.2f s\n", argv[1], rec.size(), rec.t.back() - rec.t.front());
+
+  sim::WorkPool pool(threads);
+  using Clock = std::chrono::steady_clock;
+
+  // ---- Odometry geometry ----
+  std::vector<std::pair<std::pair<double, double>, Score>> odom;
+  for (double a : lpar) for (double b : lperp) odom.push_back({{a, b}, {}});
+  auto t0 = Clock::now();
+  pool.parallel_for(odom.size(), [&](size_t k) {
+    odom[k].second = replay_odom(rec, odom[k].first.first, odom[k].first.second);
+  });
+  double wall = std::chrono::duration<double>(Clock::now() - t0).count();
+  std::printf("odometry: %zu configs in %.3f s (%.1f M samples/s)\n", odom.size(), wall,
+              odom.size() * (rec.size() - 1) / wall * 1e-6);
+  print_ranked<std::pair<double, double>>("L_par, L_perp", odom, top,
+      [](const std::pair<double, double>& c, char* buf, size_t n) {
+        std::snprintf(buf, n, "%.3f, %.3f", c.first, c.second);
+      });
+
+  // ---- Stick shaping ----
+  if (!rec.sticks) { std::printf("\nno stick channels (js_*): drive replay skipped\n"); return 0; }
+  std::vector<std::pair<xdrive::Shaping, Score>> drive;
+  for (double d : deadbands) for (double q : squares)
+    drive.push_back({xdrive::Shaping{(int)d, q != 0.0}, {}});
+  const sim::PlantParams pp;
+  t0 = Clock::now();
+  pool.parallel_for(drive.size(), [&](size_t k) {
+    drive[k].second = replay_drive(rec, drive[k].first, pp);
+  });
+  wall = std::chrono::duration<double>(Clock::now() - t0).count();
+  std::printf("\ndrive: %zu configs in %.3f s\n", drive.size(), wall);
+  print_ranked<xdrive::Shaping>("DEADBAND, SQUARE_INPUTS", drive, top,
+      [](const xdrive::Shaping& c, char* buf, size_t n) {
+        std::snprintf(buf, n, "%d, %s", c.deadband, c.square ? "true" : "false");
+      });
+  return 0;
+}
+#endif
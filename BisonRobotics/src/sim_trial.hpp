@@ -0,0 +1,312 @@
+#pragma once
+
+#ifdef SIM
+// Shared plan loop for the host tools (sim, sim_batch).
+// Drives xdrive::drive() from a joystick script, moves the chassis with the
+// wheel commands the drive motors actually received (sim::cmd_ring) and feeds
+// Odom2WIMU and the EKF (ekf.hpp) with (optionally perturbed) tracking wheel,
+// IMU and GPS readings.
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "xdrive.hpp"
+#include "ekf.hpp"
+#include "odom.hpp"
+#include "follow.hpp"
+#include "sim_compat.hpp"
+
+namespace sim {
+
+struct Cmd { double t_s; int fwd, str, rot; bool field; };
+
+// ---- Simple command script (joystick space) ----
+inline std::vector<Cmd> default_plan() {
+  return {
+    {2.0, +90,   0,   0, false},  // forward
+    {1.0,   0, +90,   0, false},  // right
+    {1.5,   0,   0, +90, false},  // rotate CW (positive in your mapping)
+    {1.0, +64, +64,   0, false},  // diagonal
+  };
+}
+
+// A 60 s skills run: six laps of driving, strafing and turning both ways.
+inline std::vector<Cmd> skills_plan() {
+  const std::vector<Cmd> lap = {
+    {2.0, +90,   0,   0, false},  // forward
+    {1.0,   0, +90,   0, false},  // right
+    {1.5,   0,   0, +90, false},  // rotate CW
+    {1.0, +64, +64,   0, false},  // diagonal
+    {1.5, -90,   0, -40, false},  // back, arcing CCW
+    {1.0,   0, -90,   0, false},  // left
+    {1.0,   0,   0, -60, false},  // rotate CCW
+    {1.0,   0,   0,   0, false},  // score
+  };
+  std::vector<Cmd> plan;
+  for (int i = 0; i < 6; ++i) plan.insert(plan.end(), lap.begin(), lap.end());
+  return plan;
+}
+
+// Scaling joystick to physical motion (tune these to your robot feel)
+struct PlantParams {
+  double   max_v_ips = 30.0;     // "full stick forward" inches/sec
+  double   max_w_rps = M_PI;     // "full stick rot" rad/sec  (180°/s)
+  double   dt        = 0.01;     // control / odometry period
+  uint32_t step_us   = 1000;     // plant integration step (1 kHz)
+};
+
+// Chassis command in joystick units, recovered from the four wheel commands.
+struct ChassisCmd { double df, ds, dr; };
+
+// Inverse of the X-drive mix in xdrive::drive():
+//   fl = df + ds + dr    fr = df - ds - dr
+//   bl = df - ds + dr    br = df + ds - dr
+inline ChassisCmd forward_kinematics(double fl, double fr, double bl, double br) {
+  return {(fl + fr + bl + br) / 4.0, (fl - fr - bl + br) / 4.0, (fl - fr + bl - br) / 4.0};
+}
+
+// Robot-frame travel: +y forward, +x right, +th CCW.
+struct Travel { double dx = 0, dy = 0, dth = 0; };
+
+// Move `p` for `dt` seconds under chassis command `u` and add the robot-frame
+// travel to `tr`. Shared by Plant and the log replay tool (sim_replay).
+inline void integrate_chassis(Pose& p, const ChassisCmd& u, double dt, const PlantParams& pp,
+                              Travel& tr) {
+  // Map joystick-space to physical velocities
+  const double vy_r = (u.df/127.0) * pp.max_v_ips;  // +forward
+  const double vx_r = (u.ds/127.0) * pp.max_v_ips;  // +right
+  // +CW in the drive mapping; odom assumes +theta is CCW, so flip for physics
+  const double omega = -(u.dr/127.0) * pp.max_w_rps;
+
+  // Integrate in field frame (midpoint)
+  const double thm = p.theta + 0.5*omega*dt;
+  const double cth = std::cos(thm), sth = std::sin(thm);
+  p.x += ( cth*vx_r - sth*vy_r) * dt;
+  p.y += ( sth*vx_r + cth*vy_r) * dt;
+  p.theta = Odom2WIMU::wrap(p.theta + omega*dt);
+
+  tr.dx += vx_r*dt; tr.dy += vy_r*dt; tr.dth += omega*dt;
+}
+
+// ---- Plant ----
+// Follows the drive motors' command rings and integrates the chassis at
+// step_us from whatever command was in effect at each step. Position-mode
+// commands carry no open-loop duty and leave that wheel at rest here; the
+// blocking helpers are exercised on the motor model instead (sim --auto).
+class Plant {
+ public:
+  explicit Plant(const Pose& start, const PlantParams& pp = {})
+      : pp_(pp), gt_(start), t_us_(sim::now_us()) {}
+
+  // Integrate up to sim time `t_us`.
+  void advance_to(uint64_t t_us) {
+    while (t_us >= t_us_ + pp_.step_us) step();
+  }
+
+  // Travel since the last take().
+  Travel take() { const Travel d = travel_; travel_ = {}; return d; }
+  const Pose& pose() const { return gt_; }
+  const ChassisCmd& cmd() const { return cmd_; }
+
+ private:
+  void step() {
+    cmd_ = forward_kinematics(127.0 * fl_.at(t_us_).duty, 127.0 * fr_.at(t_us_).duty,
+                              127.0 * bl_.at(t_us_).duty, 127.0 * br_.at(t_us_).duty);
+    integrate_chassis(gt_, cmd_, pp_.step_us * 1e-6, pp_, travel_);
+    t_us_ += pp_.step_us;
+  }
+
+  PlantParams pp_;
+  Pose gt_;
+  uint64_t t_us_;
+  ChassisCmd cmd_{0, 0, 0};
+  Travel travel_;
+  CmdCursor fl_{xdrive::PORT_FL}, fr_{xdrive::PORT_FR}, bl_{xdrive::PORT_BL}, br_{xdrive::PORT_BR};
+};
+
+// Sensor error model, drawn once per trial from `seed`. All zero = ideal.
+struct Perturb {
+  double slip_bias  = 0.0;  // per-trial scale error per tracking wheel (1-sigma, fraction)
+  double slip_noise = 0.0;  // per-sample scale error (1-sigma, fraction)
+  double tick_in    = 0.0;  // tracking-wheel encoder resolution (inches/tick, 0 = ideal)
+  double imu_drift  = 0.0;  // heading drift rate (1-sigma, rad/s)
+  double imu_noise  = 0.0;  // per-sample heading noise (1-sigma, rad)
+  double gyro_noise = 0.0;  // per-sample gyro rate noise (1-sigma, rad/s)
+  double gps_noise  = 0.0;  // GPS position noise (1-sigma, in); 0 = no GPS
+  double gps_heading_noise = 0.0;  // GPS heading noise (1-sigma, rad)
+  double gps_outlier = 0.0;        // chance a fix is off by GPS_OUTLIER_IN
+};
+
+constexpr int GPS_EVERY = 2;             // samples per GPS fix (20 ms)
+constexpr double GPS_OUTLIER_IN = 24.0;  // a reflection off the field wall
+
+struct TrialResult { Pose gt, est, ekf; };
+
+// One sample as the sim logs it.
+struct Sample {
+  double t; Pose gt, est; double df, ds, dr;
+  double sPar, sPerp, imu_heading;  // exactly what odometry was fed
+  int fwd, str, rot;                 // sticks handed to drive()
+  double gyro = 0.0;                 // IMU rate (rad/s CCW), EKF only
+  bool gps_fix = false; Pose gps{};  // GPS fix this sample, converted by ekf::gps_pose()
+  bool has_ekf = false; Pose ekf{};  // EKF estimate (run_plan() only)
+};
+
+// Encoder that only reports whole ticks of accumulated travel.
+struct TickQuantizer {
+  double tick, total = 0.0, last = 0.0;
+  explicit TickQuantizer(double t, double phase = 0.0): tick(t), total(phase * t) {
+    last = quantize();
+  }
+  double quantize() const { return tick > 0.0 ? std::floor(total / tick) * tick : total; }
+  double step(double ds) {
+    total += ds;
+    const double q = quantize(), d = q - last;
+    last = q;
+    return d;
+  }
+};
+
+// ---- Autonomous route ----
+// The encoder moves autonomous() in main.cpp falls back to without
+// FOLLOW_ROUTES, run blocking, with each move's result.
+struct RouteStep { const char* name; xdrive::MoveResult r; };
+
+inline std::array<RouteStep, 3> run_auto_route() {
+  std::array<RouteStep, 3> out;
+  out[0] = {"drive_forward_deg 24in", xdrive::drive_forward_deg(xdrive::inches_to_deg(24.0), 100)};
+  sleep_ms(300);
+  out[1] = {"strafe_right_deg 12in", xdrive::strafe_right_deg(xdrive::inches_to_deg(12.0), 100)};
+  sleep_ms(300);
+  out[2] = {"turn_cw_deg 720", xdrive::turn_cw_deg(720, 100)};
+  return out;
+}
+
+// Run `plan` once. `sink(const Sample&)` is called every step.
+template <class Sink>
+TrialResult run_plan(const std::vector<Cmd>& plan, const OdomConfig& cfg,
+                     const Perturb& pert, uint64_t seed, Sink&& sink,
+                     const PlantParams& pp = {}) {
+  std::mt19937_64 rng(seed);
+  std::normal_distribution<double> n01(0.0, 1.0);
+  std::uniform_real_distribution<double> u01(0.0, 1.0);
+
+  const double slip_par  = 1.0 + pert.slip_bias * n01(rng);
+  const double slip_perp = 1.0 + pert.slip_bias * n01(rng);
+  const double drift     = pert.imu_drift * n01(rng);
+  TickQuantizer qPar(pert.tick_in, u01(rng)), qPerp(pert.tick_in, u01(rng));
+
+  Odom2WIMU odom(cfg);
+  ekf::Ekf filt(cfg);
+  Plant plant(cfg.start, pp);
+  const uint32_t dt_ms = (uint32_t)std::lround(pp.dt * 1000.0);
+  const double dt = dt_ms / 1000.0;
+
+  double t = 0.0;
+  long n = 0;
+  for (const Cmd& c : plan) {
+    const int steps = (int)std::round(c.t_s / dt);
+    for (int k = 0; k < steps; ++k) {
+      // ---- Call your drive() just like teleop would ----
+      xdrive::drive(c.fwd, c.str, c.rot, c.field);
+      sleep_ms(dt_ms);
+
+      // The plant replays the wheel commands over the period just slept.
+      plant.advance_to(sim::now_us());
+      const Travel d = plant.take();
+      const Pose& gt = plant.pose();
+
+      // Tracking-wheel deltas from robot-centric travel
+      double sPar  = d.dy - cfg.L_par  * d.dth;
+      double sPerp = d.dx + cfg.L_perp * d.dth;
+      if (pert.slip_bias != 0.0 || pert.slip_noise != 0.0) {
+        sPar  *= slip_par  + pert.slip_noise * n01(rng);
+        sPerp *= slip_perp + pert.slip_noise * n01(rng);
+      }
+      if (pert.tick_in > 0.0) { sPar = qPar.step(sPar); sPerp = qPerp.step(sPerp); }
+
+      // IMU heading is absolute field orientation (+ drift and noise)
+      double imu_heading = gt.theta;
+      if (drift != 0.0 || pert.imu_noise != 0.0)
+        imu_heading = Odom2WIMU::wrap(imu_heading + drift*(t + dt) + pert.imu_noise*n01(rng));
+
+      // Gyro: the true rate over the period, off by the same drift
+      double gyro = d.dth / dt + drift;
+      if (pert.gyro_noise != 0.0) gyro += pert.gyro_noise * n01(rng);
+
+      odom.update(sPar, sPerp, imu_heading);
+      filt.step(sPar, sPerp, gyro, imu_heading, dt);
+
+      // GPS in PROS units (meters, degrees CW from north), as localize.cpp reads it
+      bool gps_fix = false;
+      Pose gps{};
+      if (pert.gps_noise > 0.0 && ++n % GPS_EVERY == 0) {
+        constexpr double M_PER_IN = 0.0254;
+        double x_m = (gt.x + pert.gps_noise * n01(rng)) * M_PER_IN;
+        const double y_m = (gt.y + pert.gps_noise * n01(rng)) * M_PER_IN;
+        double h_deg = -(gt.theta + pert.gps_heading_noise * n01(rng)) * 180.0 / M_PI;
+        h_deg = std::fmod(h_deg + 360.0, 360.0);
+        if (pert.gps_outlier > 0.0 && u01(rng) < pert.gps_outlier) x_m += GPS_OUTLIER_IN * M_PER_IN;
+        gps = ekf::gps_pose(x_m, y_m, h_deg);
+        gps_fix = true;
+        filt.update_gps(gps, pert.gps_noise);
+      }
+
+      const ChassisCmd& u = plant.cmd();
+      sink(Sample{t, gt, odom.pose(), u.df, u.ds, u.dr, sPar, sPerp, imu_heading,
+                  c.fwd, c.str, c.rot, gyro, gps_fix, gps, true, filt.pose()});
+
+      t += dt;
+    }
+  }
+  return {plant.pose(), odom.pose(), filt.pose()};
+}
+
+// ---- Path following ----
+// Drive `path` with follow::Follower through drive()'s field-centric mapping,
+// with ideal tracking wheels and the IMU mock fed the plant heading. Runs
+// until the follower is done or `timeout_s` after the path ends.
+struct FollowResult { Pose gt, est; double t_s; bool done; double max_err_xy; };
+
+template <class Sink>
+FollowResult run_follow(const follow::Path& path, const OdomConfig& cfg, Sink&& sink,
+                        const follow::Gains& g = {}, double timeout_s = 2.0,
+                        const PlantParams& pp = {}) {
+  Odom2WIMU odom(cfg);
+  Plant plant(cfg.start, pp);
+  follow::Follower f(path, g);
+  const uint32_t dt_ms = (uint32_t)std::lround(pp.dt * 1000.0);
+  const double dt = dt_ms / 1000.0;
+  xdrive::sim_set_heading(cfg.start.theta * 180.0 / M_PI);
+
+  FollowResult res{cfg.start, cfg.start, 0.0, false, 0.0};
+  double t = 0.0;
+  while (t < path.duration() + timeout_s) {
+    const follow::Command c = f.update(odom.pose(), t);
+    res.max_err_xy = std::max(res.max_err_xy, f.error_xy());
+    if (f.done(t)) { res.done = true; break; }
+    xdrive::drive(c.fwd, c.str, c.rot, true);
+    sleep_ms(dt_ms);
+
+    plant.advance_to(sim::now_us());
+    const Travel d = plant.take();
+    const Pose& gt = plant.pose();
+    const double sPar  = d.dy - cfg.L_par  * d.dth;
+    const double sPerp = d.dx + cfg.L_perp * d.dth;
+    odom.update(sPar, sPerp, gt.theta);
+    xdrive::sim_set_heading(gt.theta * 180.0 / M_PI);
+
+    const ChassisCmd& u = plant.cmd();
+    // No EKF or GPS here: the follower steers by odometry alone.
+    sink(Sample{t, gt, odom.pose(), u.df, u.ds, u.dr, sPar, sPerp, gt.theta, c.fwd, c.str, c.rot,
+                d.dth / dt});
+    t += dt;
+  }
+  xdrive::drive(0, 0, 0);
+  res.gt = plant.pose(); res.est = odom.pose(); res.t_s = t;
+  return res;
+}
+
+} // namespace sim
+#endif
@@ -0,0 +1,190 @@
+#ifdef SIM
+// Offline autotuner for xdrive::PosGains.
+// Runs the autonomous() helper route on the motor model for a population of
+// candidate gain sets in parallel and minimizes
+//   cost = sum over moves of  settle_s + W_OVERSHOOT*overshoot_deg + W_ERROR*error_deg
+//          (+ TIMEOUT_PENALTY for a move that never settles)
+// with a separable CMA-ES over log10(kP, kI, kD, kS). Each candidate runs on
+// its own pool thread with its own virtual clock and motors, so results do
+// not depend on -j. Prints the best gains as a PosGains initializer.
+//
+// Build: g++ -DSIM -O2 -std=gnu++17 -Iinclude -pthread -o sim_tune
+//          src/sim_tune.cpp src/xdrive.cpp src/control.cpp src/sim_pros.cpp
+// Usage: sim_tune [-g generations] [-p population] [-j threads] [--seed s]
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "xdrive.hpp"
+#include "sim_compat.hpp"
+#include "sim_trial.hpp"
+#include "sim_pool.hpp"
+
+constexpr int    N_PARAMS        = 4;      // log10 of kP, kI, kD, kS
+constexpr double W_OVERSHOOT     = 0.01;   // s per degree of overshoot
+constexpr double W_ERROR         = 0.05;   // s per degree of final error
+constexpr double TIMEOUT_PENALTY = 5.0;    // s
+// Search box (log10). kP/kD stop short of bang-bang gains that only work
+// because the model has no sensor noise or latency.
+constexpr double LOG_MIN[N_PARAMS] = {-3.0, -6.0, -5.0, -3.0};
+constexpr double LOG_MAX[N_PARAMS] = { 0.0,  0.0, -1.0,  0.3};
+
+using Vec = std::array<double, N_PARAMS>;
+
+static xdrive::PosGains to_gains(const Vec& x) {
+  xdrive::PosGains g;
+  g.kP = std::pow(10.0, x[0]); g.kI = std::pow(10.0, x[1]);
+  g.kD = std::pow(10.0, x[2]); g.kS = std::pow(10.0, x[3]);
+  return g;
+}
+
+// Score one candidate on a fresh robot (called on a pool thread).
+static double evaluate(const Vec& x) {
+  sim::set_clock_mode(sim::ClockMode::Fast);
+  sim::reset_clock();
+  xdrive::initialize();
+  xdrive::set_position_gains(to_gains(x));
+  double cost = 0.0;
+  for (const sim::RouteStep& s : sim::run_auto_route()) {
+    cost += s.r.ms / 1000.0 + W_OVERSHOOT * s.r.overshoot_deg + W_ERROR * s.r.error_deg;
+    if (!s.r.settled) cost += TIMEOUT_PENALTY;
+  }
+  return cost;
+}
+
+// ---- Separable CMA-ES (diagonal covariance) ----
+// Hansen's default parameters with the sep-CMA learning-rate scaling.
+class SepCMA {
+ public:
+  SepCMA(const Vec& mean, double sigma, int lambda, uint64_t seed)
+      : m_(mean), sigma_(sigma), lambda_(lambda), mu_(lambda / 2), rng_(seed) {
+    const int n = N_PARAMS;
+    w_.resize(mu_);
+    for (int i = 0; i < mu_; ++i) w_[i] = std::log(mu_ + 0.5) - std::log(i + 1.0);
+    const double sw = std::accumulate(w_.begin(), w_.end(), 0.0);
+    for (double& w : w_) w /= sw;
+    double sw2 = 0.0;
+    for (double w : w_) sw2 += w * w;
+    mueff_ = 1.0 / sw2;
+
+    cs_ = (mueff_ + 2.0) / (n + mueff_ + 5.0);
+    ds_ = 1.0 + 2.0 * std::max(0.0, std::sqrt((mueff_ - 1.0) / (n + 1.0)) - 1.0) + cs_;
+    cc_ = (4.0 + mueff_ / n) / (n + 4.0 + 2.0 * mueff_ / n);
+    const double sep = (n + 2.0) / 3.0;
+    c1_ = sep * 2.0 / ((n + 1.3) * (n + 1.3) + mueff_);
+    cmu_ = std::min(1.0 - c1_, sep * 2.0 * (mueff_ - 2.0 + 1.0 / mueff_) /
+                                   ((n + 2.0) * (n + 2.0) + mueff_));
+    chi_n_ = std::sqrt((double)n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+    C_.fill(1.0); ps_.fill(0.0); pc_.fill(0.0);
+  }
+
+  // Draw a generation (clamped to the search box).
+  std::vector<Vec> ask() {
+    std::normal_distribution<double> n01(0.0, 1.0);
+    std::vector<Vec> xs(lambda_);
+    for (Vec& x : xs)
+      for (int d = 0; d < N_PARAMS; ++d)
+        x[d] = std::max(LOG_MIN[d], std::min(LOG_MAX[d], m_[d] + sigma_ * std::sqrt(C_[d]) * n01(rng_)));
+    return xs;
+  }
+
+  void tell(const std::vector<Vec>& xs, const std::vector<double>& cost) {
+    std::vector<int> idx(xs.size());
+    std::iota(idx.begin(), idx.end(), 0);
+    std::sort(idx.begin(), idx.end(), [&](int a, int b){ return cost[a] < cost[b]; });
+
+    const Vec old = m_;
+    m_.fill(0.0);
+    for (int i = 0; i < mu_; ++i)
+      for (int d = 0; d < N_PARAMS; ++d) m_[d] += w_[i] * xs[idx[i]][d];
+
+    double ps_norm2 = 0.0;
+    Vec ymean;
+    for (int d = 0; d < N_PARAMS; ++d) {
+      ymean[d] = (m_[d] - old[d]) / sigma_;
+      ps_[d] = (1.0 - cs_) * ps_[d] + std::sqrt(cs_ * (2.0 - cs_) * mueff_) * ymean[d] / std::sqrt(C_[d]);
+      ps_norm2 += ps_[d] * ps_[d];
+    }
+    ++gen_;
+    const double ps_norm = std::sqrt(ps_norm2);
+    const bool hs = ps_norm / std::sqrt(1.0 - std::pow(1.0 - cs_, 2.0 * gen_)) <
+                    (1.4 + 2.0 / (N_PARAMS + 1.0)) * chi_n_;
+    for (int d = 0; d < N_PARAMS; ++d) {
+      pc_[d] = (1.0 - cc_) * pc_[d] + (hs ? std::sqrt(cc_ * (2.0 - cc_) * mueff_) * ymean[d] : 0.0);
+      double rank_mu = 0.0;
+      for (int i = 0; i < mu_; ++i) {
+        const double y = (xs[idx[i]][d] - old[d]) / sigma_;
+        rank_mu += w_[i] * y * y;
+      }
+      C_[d] = (1.0 - c1_ - cmu_) * C_[d] + c1_ * pc_[d] * pc_[d] + cmu_ * rank_mu;
+    }
+    sigma_ = std::min(2.0, sigma_ * std::exp(cs_ / ds_ * (ps_norm / chi_n_ - 1.0)));
+  }
+
+  const Vec& mean() const { return m_; }
+  double sigma() const { return sigma_; }
+
+ private:
+  Vec m_, C_, ps_, pc_;
+  double sigma_;
+  int lambda_, mu_, gen_ = 0;
+  std::vector<double> w_;
+  double mueff_, cs_, ds_, cc_, c1_, cmu_, chi_n_;
+  std::mt19937_64 rng_;
+};
+
+int main(int argc, char** argv) {
+  int generations = 40, population = 16;
+  unsigned threads = 0;
+  uint64_t seed = 1;
+  for (int i = 1; i < argc; ++i) {
+    auto arg = [&](const char* name){ return !std::strcmp(argv[i], name) && i + 1 < argc; };
+    if      (arg("-g"))     generations = std::atoi(argv[++i]);
+    else if (arg("-p"))     population  = std::max(4, std::atoi(argv[++i]));
+    else if (arg("-j"))     threads     = std::atoi(argv[++i]);
+    else if (arg("--seed")) seed        = std::strtoull(argv[++i], nullptr, 10);
+    else { std::fprintf(stderr, "unknown argument: %s\n", argv[i]); return 2; }
+  }
+
+  // Start from the compiled-in defaults, one decade wide.
+  const xdrive::PosGains g0;
+  const Vec x0 = {std::log10(g0.kP), std::log10(g0.kI), std::log10(g0.kD), std::log10(g0.kS)};
+  SepCMA es(x0, 1.0, population, seed);
+
+  sim::WorkPool pool(threads);
+  Vec best = x0;
+  double best_cost = evaluate(x0);
+  std::printf("defaults: cost %.4f\n", best_cost);
+
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int gen = 0; gen < generations; ++gen) {
+    const std::vector<Vec> xs = es.ask();
+    std::vector<double> cost(xs.size());
+    pool.parallel_for(xs.size(), [&](size_t i){ cost[i] = evaluate(xs[i]); });
+    es.tell(xs, cost);
+
+    const size_t k = std::min_element(cost.begin(), cost.end()) - cost.begin();
+    if (cost[k] < best_cost) { best_cost = cost[k]; best = xs[k]; }
+    std::printf("gen %3d  best %.4f  gen-best %.4f  sigma %.4f\n", gen, best_cost, cost[k], es.sigma());
+  }
+  const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  const xdrive::PosGains g = to_gains(best);
+  std::printf("\n%d evaluations on %u threads in %.2f s\n", generations * population, pool.size(), wall);
+  sim::reset_clock();
+  xdrive::initialize();
+  xdrive::set_position_gains(g);
+  std::printf("%-22s %8s %10s %10s\n", "move", "ms", "overshoot", "error");
+  for (const sim::RouteStep& s : sim::run_auto_route())
+    std::printf("%-22s %8u %10.2f %10.2f%s\n", s.name, (unsigned)s.r.ms, s.r.overshoot_deg,
+                s.r.error_deg, s.r.settled ? "" : "  (timeout)");
+  std::printf("\nPosGains: kP = %.4g, kI = %.4g, kD = %.4g, kS = %.4g;\n", g.kP, g.kI, g.kD, g.kS);
+  return 0;
+}
+#endif
@@ -0,0 +1,283 @@
+#ifdef SIM
+// Host decoder for the robot's serial telemetry stream (telemetry.hpp,
+// wire.hpp). Prints one CSV line per record:
+//   wheels, t_s, seq, mv_fl, mv_fr, mv_bl, mv_br, rpm_fl, rpm_fr, rpm_bl, rpm_br
+//   pose,   t_s, seq, x_in, y_in, theta_rad
+//   loops,  t_s, seq, {name, exec_us, wcet_us, jitter_max_us, overruns}...
+//   event,  t_s, seq, kind, a, b                  (logger::Event)
+// and the frame statistics to stderr at the end.
+//
+// --loopback runs the sim robot's stream (default joystick plan, telemetry
+// loop on the emulated scheduler) into one end of a pseudo-terminal and
+// decodes the other end, checking that every record arrives intact. With
+// --sdlog DIR the SD logger (logger.hpp) records the same run into DIR, and
+// the log file is decoded and checked afterwards.
+//
+// Build: g++ -DSIM -O2 -std=gnu++17 -Iinclude -pthread -o telem_decode
+//          src/telem_decode.cpp src/telemetry.cpp src/logger.cpp src/xdrive.cpp src/control.cpp
+//          src/sim_pros.cpp
+// Usage: telem_decode <tty|file>          (a tty is switched to raw mode; also /usd/brlog_NN.bin)
+//        telem_decode --loopback [--lz4] [--quiet] [--sdlog DIR] [seconds]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "sim_compat.hpp"
+#include "sim_trial.hpp"
+#include "logger.hpp"
+#include "telemetry.hpp"
+#include "wire.hpp"
+
+// Decodes records and keeps the counts the loopback check needs.
+class Decoder {
+ public:
+  explicit Decoder(bool print): print_(print) {}
+
+  void push(const uint8_t* p, size_t n) {
+    bytes_ += n;
+    deframer_.push(p, n, [&](const wire::Header& h, const uint8_t* pl, size_t m) {
+      if (h.channel != wire::BLOCK) { record(h, pl, m); return; }
+      ++blocks_;
+      if (!wire::unpack_block(h.flags, pl, m, [&](const uint8_t* r, size_t len) {
+            record(wire::get_header(r), r + wire::HEADER, len - wire::HEADER);
+          }))
+        ++bad_blocks_;
+    });
+  }
+
+  void report(std::FILE* f) const {
+    const wire::DeframerStats& s = deframer_.stats();
+    std::fprintf(f, "%llu bytes, %u frames (%u blocks), %u records: %u wheels, %u pose, %u loops, %u events\n",
+                 (unsigned long long)bytes_, (unsigned)s.frames, (unsigned)blocks_,
+                 (unsigned)records_, (unsigned)per_channel_[wire::WHEELS],
+                 (unsigned)per_channel_[wire::POSE], (unsigned)per_channel_[wire::LOOPS],
+                 (unsigned)per_channel_[wire::EVENT]);
+    std::fprintf(f, "errors: %u bad COBS, %u bad CRC, %u oversize, %u bad blocks, %u seq gaps\n",
+                 (unsigned)s.bad_cobs, (unsigned)s.bad_crc, (unsigned)s.overflow,
+                 (unsigned)bad_blocks_, (unsigned)gaps_);
+  }
+  bool clean() const {
+    const wire::DeframerStats& s = deframer_.stats();
+    return !s.bad_cobs && !s.bad_crc && !s.overflow && !bad_blocks_ && !gaps_;
+  }
+  uint32_t frames() const { return deframer_.stats().frames; }
+  uint32_t records() const { return records_; }
+  uint32_t wheels() const { return per_channel_[wire::WHEELS]; }
+  uint32_t events() const { return per_channel_[wire::EVENT]; }
+
+ private:
+  void count_seq(uint16_t seq) {
+    if (have_seq_ && seq != (uint16_t)(last_seq_ + 1)) ++gaps_;
+    have_seq_ = true;
+    last_seq_ = seq;
+  }
+
+  void record(const wire::Header& h, const uint8_t* p, size_t n) {
+    count_seq(h.seq);
+    ++records_;
+    if (h.channel < 8) ++per_channel_[h.channel];
+    const double t = h.t_us * 1e-6;
+    switch (h.channel) {
+      case wire::WHEELS: {
+        if (n < 16 || !print_) break;
+        int16_t v[8];
+        for (int16_t& x : v) x = wire::get<int16_t>(p);
+        std::printf("wheels, %.3f, %u, %d, %d, %d, %d, %.1f, %.1f, %.1f, %.1f\n", t, (unsigned)h.seq,
+                    v[0], v[1], v[2], v[3], v[4] / 10.0, v[5] / 10.0, v[6] / 10.0, v[7] / 10.0);
+        break;
+      }
+      case wire::POSE: {
+        if (n < 12 || !print_) break;
+        const float x = wire::get<float>(p), y = wire::get<float>(p), th = wire::get<float>(p);
+        std::printf("pose, %.3f, %u, %.3f, %.3f, %.4f\n", t, (unsigned)h.seq, x, y, th);
+        break;
+      }
+      case wire::NAMES:
+        names_.clear();
+        for (const uint8_t* e = p + n; p < e;) {
+          const size_t len = strnlen((const char*)p, e - p);
+          names_.emplace_back((const char*)p, len);
+          p += len + 1;
+        }
+        break;
+      case wire::EVENT: {
+        if (n < 9 || !print_) break;
+        const unsigned kind = wire::get<uint8_t>(p);
+        const int32_t a = wire::get<int32_t>(p), b = wire::get<int32_t>(p);
+        std::printf("event, %.3f, %u, %u, %d, %d\n", t, (unsigned)h.seq, kind, (int)a, (int)b);
+        break;
+      }
+      case wire::LOOPS: {
+        if (n < 1 || !print_) break;
+        const unsigned k = wire::get<uint8_t>(p);
+        if (n < 1 + 8 * k) break;
+        std::printf("loops, %.3f, %u", t, (unsigned)h.seq);
+        for (unsigned i = 0; i < k; ++i) {
+          const unsigned exec = wire::get<uint16_t>(p), wcet = wire::get<uint16_t>(p);
+          const unsigned jit = wire::get<uint16_t>(p), ovr = wire::get<uint16_t>(p);
+          std::printf(", %s, %u, %u, %u, %u", i < names_.size() ? names_[i].c_str() : "?", exec, wcet,
+                      jit, ovr);
+        }
+        std::printf("\n");
+        break;
+      }
+    }
+  }
+
+  bool print_;
+  wire::Deframer deframer_;
+  uint64_t bytes_ = 0;
+  uint32_t records_ = 0, blocks_ = 0, bad_blocks_ = 0, gaps_ = 0;
+  uint32_t per_channel_[8] = {};
+  bool have_seq_ = false;
+  uint16_t last_seq_ = 0;
+  std::vector<std::string> names_;
+};
+
+static void make_raw(int fd) {
+  termios tio;
+  if (tcgetattr(fd, &tio) != 0) return;  // not a tty
+  cfmakeraw(&tio);
+  tcsetattr(fd, TCSANOW, &tio);
+}
+
+static bool decode_fd(const char* path, Decoder& dec) {
+  const int fd = open(path, O_RDONLY | O_NOCTTY);
+  if (fd < 0) { std::perror(path); return false; }
+  make_raw(fd);
+  uint8_t buf[4096];
+  ssize_t n;
+  while ((n = read(fd, buf, sizeof buf)) > 0) dec.push(buf, n);
+  close(fd);
+  return true;
+}
+
+static int decode_path(const char* path) {
+  Decoder dec(true);
+  if (!decode_fd(path, dec)) return 1;
+  dec.report(stderr);
+  return 0;
+}
+
+// Decode the logger's file and compare with what it says it wrote.
+static bool check_sdlog() {
+  const logger::Stats& ls = logger::stats();
+  std::fprintf(stderr, "sdlog %s: %u ticks (%u dropped), %u events (%u dropped), %u buffers, %u blocks, "
+               "%llu raw -> %llu file bytes\n",
+               logger::path(), (unsigned)ls.ticks, (unsigned)ls.dropped_ticks, (unsigned)ls.events,
+               (unsigned)ls.dropped_events, (unsigned)ls.buffers, (unsigned)ls.blocks,
+               (unsigned long long)ls.raw_bytes, (unsigned long long)ls.file_bytes);
+  Decoder dec(false);
+  if (!decode_fd(logger::path(), dec)) return false;
+  dec.report(stderr);
+  return dec.clean() && dec.frames() == ls.blocks && dec.wheels() == ls.ticks &&
+         dec.events() == ls.events && !ls.write_errors;
+}
+
+static int pty_writer = -1;
+
+static void write_pty(const uint8_t* p, size_t n) {
+  while (n) {
+    const ssize_t w = write(pty_writer, p, n);
+    if (w <= 0) return;
+    p += w; n -= w;
+  }
+}
+
+static int loopback(double seconds, bool lz4_blocks, bool quiet, const char* sdlog) {
+  const int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) || unlockpt(master)) { std::perror("pty"); return 1; }
+  const int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+  if (slave < 0) { std::perror(ptsname(master)); return 1; }
+  make_raw(master);
+  make_raw(slave);
+
+  Decoder dec(!quiet);
+  std::atomic<bool> done{false};
+  std::thread reader([&] {
+    uint8_t buf[4096];
+    while (true) {
+      pollfd pfd{slave, POLLIN, 0};
+      if (poll(&pfd, 1, 200) <= 0) { if (done) break; continue; }
+      const ssize_t n = read(slave, buf, sizeof buf);
+      if (n <= 0) break;
+      dec.push(buf, n);
+    }
+  });
+
+  // The robot side: sim plan for `seconds`, the stream loop on the emulated
+  // scheduler, frames written to the pty master.
+  sim::set_clock_mode(sim::ClockMode::Fast);
+  xdrive::initialize();
+  pty_writer = master;
+  telemetry::set_sink(write_pty);
+  std::vector<sim::Cmd> plan;
+  for (double t = 0.0; t < seconds;)
+    for (const sim::Cmd& c : sim::default_plan()) { plan.push_back(c); t += c.t_s; }
+  OdomConfig cfg; cfg.L_par = 3.0; cfg.L_perp = 4.0; cfg.start = {0, 0, 0};
+
+  if (sdlog) {
+    xdrive::start_sensors();
+    if (!logger::start(sdlog)) { std::fprintf(stderr, "cannot log to %s\n", sdlog); return 1; }
+  }
+
+  const auto t0 = std::chrono::steady_clock::now();
+  telemetry::start_stream(lz4_blocks);
+  // A MODE event whenever the plan's sticks change (logged only with --sdlog)
+  int last_fwd = 1000;
+  sim::run_plan(plan, cfg, sim::Perturb{}, 0, [&](const sim::Sample& s) {
+    telemetry::publish_pose(s.est);
+    if (s.fwd != last_fwd) logger::event(logger::Event::MODE, 2, s.fwd);
+    last_fwd = s.fwd;
+  });
+  telemetry::stop_stream();
+  if (sdlog) logger::stop();
+  sim::kill_all_tasks();
+  done = true;
+  reader.join();
+  const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  close(slave);
+  close(master);
+
+  const telemetry::StreamStats& st = telemetry::stream_stats();
+  const double sim_s = now_ms() / 1000.0;
+  std::fprintf(stderr, "sent: %u ticks (%u dropped) in %.2f s sim time (%.0f Hz), %u frames, %llu record bytes -> %llu wire bytes (%.0f B/s at 100 Hz)\n",
+               (unsigned)st.ticks, (unsigned)st.dropped, sim_s, st.ticks / sim_s, (unsigned)st.frames,
+               (unsigned long long)st.record_bytes, (unsigned long long)st.wire_bytes,
+               st.wire_bytes / sim_s);
+  dec.report(stderr);
+  std::fprintf(stderr, "pty throughput %.0f frames/s wall\n", dec.frames() / wall);
+  bool ok = dec.clean() && dec.frames() == st.frames && !st.dropped;
+  if (sdlog) ok = check_sdlog() && ok;
+  std::fprintf(stderr, "%s\n", ok ? "loopback OK" : "loopback FAILED");
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && !std::strcmp(argv[1], "--loopback")) {
+    bool lz4_blocks = false, quiet = false;
+    const char* sdlog = nullptr;
+    double seconds = 5.5;
+    for (int i = 2; i < argc; ++i) {
+      if      (!std::strcmp(argv[i], "--lz4"))   lz4_blocks = true;
+      else if (!std::strcmp(argv[i], "--quiet")) quiet = true;
+      else if (!std::strcmp(argv[i], "--sdlog") && i + 1 < argc) sdlog = argv[++i];
+      else seconds = std::atof(argv[i]);
+    }
+    return loopback(seconds, lz4_blocks, quiet, sdlog);
+  }
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: telem_decode <tty|file> | --loopback [--lz4] [--quiet] [--sdlog DIR] [seconds]\n");
+    return 2;
+  }
+  return decode_path(argv[1]);
+}
+#endif
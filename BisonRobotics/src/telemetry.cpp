@@ -0,0 +1,191 @@
+#ifdef SIM
+#include "sim_compat.hpp"
+#else
+#include "main.h"
+#include "pros/apix.h"
+#endif
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "telemetry.hpp"
+#include "control.hpp"
+#include "lz4block.hpp"
+#include "ring.hpp"
+#include "seqlock.hpp"
+#include "wire.hpp"
+#include "xdrive.hpp"
+
+namespace telemetry {
+
+constexpr int BLOCK_TICKS = 10;   // ticks per compressed block
+constexpr int NAMES_EVERY = 100;  // ticks between loop-name records
+
+static Seqlock<Pose> pose_bus;
+
+void publish_pose(const Pose& p) { pose_bus.store(p); }
+
+bool latest_pose(Pose& out) {
+  if (!pose_bus.version()) return false;
+  out = pose_bus.load();
+  return true;
+}
+
+#ifdef SIM
+static void default_sink(const uint8_t*, size_t) {}
+#else
+static void default_sink(const uint8_t* data, size_t n) {
+  std::fwrite(data, 1, n, stdout);
+  std::fflush(stdout);
+}
+#endif
+
+// ---- Records ----
+static uint8_t* open_entry(uint8_t* entry, wire::Channel ch, uint16_t& seq, uint32_t t_us) {
+  return wire::put_header(entry + 2, {ch, 0, seq++, t_us});
+}
+static uint8_t* close_entry(uint8_t* entry, uint8_t* p) {
+  const uint16_t len = static_cast<uint16_t>(p - entry - 2);
+  std::memcpy(entry, &len, 2);
+  return p;
+}
+
+static int16_t sat16(double v) {
+  return static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, std::round(v))));
+}
+static uint16_t satu16(uint32_t v) { return static_cast<uint16_t>(std::min<uint32_t>(v, 65535)); }
+
+size_t pack_tick(const xdrive::Snapshot& sn, uint16_t& seq, bool names, uint8_t* out, size_t cap) {
+  if (cap < TICK_MAX) return 0;
+  const uint32_t t_us = static_cast<uint32_t>(sn.t_us);
+  uint8_t *e = out, *p;
+
+  p = open_entry(e, wire::WHEELS, seq, t_us);
+  for (int k = 0; k < 4; ++k) wire::put(p, sat16(sn.mv[k]));
+  for (int k = 0; k < 4; ++k) wire::put(p, sat16(sn.rpm[k] * 10.0));
+  e = close_entry(e, p);
+
+  Pose pose;
+  if (latest_pose(pose)) {
+    p = open_entry(e, wire::POSE, seq, t_us);
+    wire::put(p, static_cast<float>(pose.x));
+    wire::put(p, static_cast<float>(pose.y));
+    wire::put(p, static_cast<float>(pose.theta));
+    e = close_entry(e, p);
+  }
+
+  const size_t n_loops = control::loop_count();  // at most 16
+  if (names) {
+    p = open_entry(e, wire::NAMES, seq, t_us);
+    for (size_t i = 0; i < n_loops; ++i) {
+      const size_t len = std::min<size_t>(std::strlen(control::loop(i).name()), 23);
+      std::memcpy(p, control::loop(i).name(), len);
+      p += len;
+      *p++ = 0;
+    }
+    e = close_entry(e, p);
+  }
+
+  p = open_entry(e, wire::LOOPS, seq, t_us);
+  wire::put(p, static_cast<uint8_t>(n_loops));
+  for (size_t i = 0; i < n_loops; ++i) {
+    const control::Stats& s = control::loop(i).stats();
+    wire::put(p, satu16(s.exec_last_us));
+    wire::put(p, satu16(s.wcet_us));
+    wire::put(p, satu16(s.jitter_max_us));
+    wire::put(p, satu16(s.overruns));
+  }
+  e = close_entry(e, p);
+  return e - out;
+}
+
+// ---- Serial stream ----
+struct Stream {
+  Sink sink = default_sink;
+  bool lz4_blocks = false;
+  uint16_t seq = 0;
+  int tick = 0;
+  // BLOCK mode: records of the current block as {u16 len, record}
+  uint8_t block[wire::BLOCK_RAW];
+  size_t block_len = 0;
+  lz4::Table table;
+  StreamStats stats;
+};
+static Stream st;
+
+void set_sink(Sink s) { st.sink = s ? s : default_sink; }
+const StreamStats& stream_stats() { return st.stats; }
+
+static void send(const uint8_t* record, size_t n) {
+  uint8_t out[wire::MAX_FRAME];
+  const size_t m = wire::frame(record, n, out);
+  st.sink(out, m);
+  ++st.stats.frames;
+  st.stats.wire_bytes += m;
+}
+
+static void flush_block() {
+  if (!st.block_len) return;
+  uint8_t rec[wire::MAX_RECORD];
+  send(rec, wire::pack_block(st.block, st.block_len, rec, st.table));
+  st.block_len = 0;
+}
+
+// Every snapshot from the sensors loop, so each one is sent exactly once
+// even when the two loops' releases drift apart.
+static ring::SpscRing<xdrive::Snapshot, 16> samples;
+
+static void on_sample(const xdrive::Snapshot& s) {
+  if (!samples.push(s)) ++st.stats.dropped;
+}
+
+static void send_tick(const xdrive::Snapshot& sn) {
+  uint8_t buf[TICK_MAX];
+  const size_t n = pack_tick(sn, st.seq, st.tick % NAMES_EVERY == 0, buf, sizeof buf);
+  if (!st.lz4_blocks) {
+    wire::for_each_entry(buf, n, [](const uint8_t* record, size_t len) {
+      st.stats.record_bytes += len;
+      send(record, len);
+    });
+  } else {
+    if (st.block_len + n > sizeof st.block) flush_block();
+    std::memcpy(st.block + st.block_len, buf, n);
+    st.block_len += n;
+    wire::for_each_entry(buf, n, [](const uint8_t*, size_t len) { st.stats.record_bytes += len; });
+  }
+
+  ++st.tick;
+  ++st.stats.ticks;
+  if (st.lz4_blocks && st.tick % BLOCK_TICKS == 0) flush_block();
+}
+
+void stream_tick() {
+  if (!xdrive::sensors_running()) { send_tick(xdrive::sensors()); return; }  // host tools
+  xdrive::Snapshot sn;
+  while (samples.pop(sn)) send_tick(sn);
+}
+
+// Below drive and sensors, above the screen
+static control::Loop loop("stream", 10, TASK_PRIORITY_DEFAULT - 1, stream_tick);
+
+void start_stream(bool lz4_blocks) {
+#ifndef SIM
+  pros::c::serctl(SERCTL_DISABLE_COBS, nullptr);  // raw bytes on stdout
+#endif
+  st.lz4_blocks = lz4_blocks;
+  st.block_len = 0;
+  samples.clear();
+  xdrive::add_sample_hook(on_sample);
+  loop.start();
+}
+
+void stop_stream() {
+  loop.stop();
+  xdrive::remove_sample_hook(on_sample);
+  if (st.lz4_blocks) flush_block();
+#ifndef SIM
+  pros::c::serctl(SERCTL_ENABLE_COBS, nullptr);  // printf() back to the PROS terminal
+#endif
+}
+
+} // namespace telemetry
@@ -1,222 +1,622 @@
 #include "sim_compat.hpp"
 #include "xdrive.hpp"
+#include "control.hpp"
+#include "seqlock.hpp"
+#ifndef SIM
+#include "dashboard.hpp"
+#endif
+#include <atomic>
 #include <cmath>
 
 namespace xdrive {
 
-// --- Construct motors with just the port, then set options via setters ---
+// ---- Chassis I/O ----
+// The four drive motors behind one object, in FL, FR, BL, BR order. Setup and
+// stop go to the whole group at once; reads fill the caller's fixed
+// arrays. Wheel commands carry a different value per wheel, which
+// MotorGroup cannot send, so they go out back to back on the same tick.
+// MotorGroup's *_all() reads return a new std::vector per call, so the 10 ms
+// path reads by index instead.
+class Chassis {
+ public:
+  void configure() {
+#ifdef SIM
+    for (MotorMock& m : m_) { m.set_gearing(GEARSET); m.set_encoder_units(ENCODERS); }
+#else
+    group_.set_gearing_all(GEARSET);
+    group_.set_encoder_units_all(ENCODERS);
+#endif
+  }
+  void stop() {
+#ifdef SIM
+    for (MotorMock& m : m_) m.move_voltage(0);
+#else
+    group_.move_voltage(0);
+#endif
+  }
+  void move(const int v[4]) { for (int k = 0; k < 4; ++k) m_[k].move(v[k]); }
+  void move_voltage(const int mv[4]) { for (int k = 0; k < 4; ++k) m_[k].move_voltage(mv[k]); }
+  void read(double pos_deg[4], double rpm[4], double mv[4]) {
+    for (int k = 0; k < 4; ++k) {
+      pos_deg[k] = m_[k].get_position();
+      rpm[k] = m_[k].get_actual_velocity();
+      mv[k] = m_[k].get_voltage();
+    }
+  }
+
+ private:
 #ifdef SIM
-  // ---- SIM motors/IMU ----
-  static MotorMock mFL(PORT_FL, REVERSED_FL);
-  static MotorMock mFR(PORT_FR, REVERSED_FR);
-  static MotorMock mBL(PORT_BL, REVERSED_BL);
-  static MotorMock mBR(PORT_BR, REVERSED_BR);
-  static ImuMock   imu;
-#else  // ---- Real PROS motors/IMU ----
-static pros::Motor mFL(PORT_FL);
-static pros::Motor mFR(PORT_FR);
-static pros::Motor mBL(PORT_BL);
-static pros::Motor mBR(PORT_BR);
+  MotorMock m_[4] = {MotorMock(PORT_FL, REVERSED_FL), MotorMock(PORT_FR, REVERSED_FR),
+                     MotorMock(PORT_BL, REVERSED_BL), MotorMock(PORT_BR, REVERSED_BR)};
+#else
+  // Negative ports reverse a motor (PROS 4).
+  static constexpr std::int8_t port(int p, bool rev) { return static_cast<std::int8_t>(rev ? -p : p); }
+  pros::MotorGroup group_{port(PORT_FL, REVERSED_FL), port(PORT_FR, REVERSED_FR),
+                          port(PORT_BL, REVERSED_BL), port(PORT_BR, REVERSED_BR)};
+  pros::Motor m_[4] = {pros::Motor(port(PORT_FL, REVERSED_FL)), pros::Motor(port(PORT_FR, REVERSED_FR)),
+                       pros::Motor(port(PORT_BL, REVERSED_BL)), pros::Motor(port(PORT_BR, REVERSED_BR))};
 #endif
+};
 
-static inline int deadband(int v) { return (std::abs(v) < DEADBAND) ? 0 : v; }
-static inline double signed_square(int v) {
-  const double s = v / 127.0;
-  return std::copysign(s * s, s) * 127.0;
+#ifdef SIM
+  // ---- SIM chassis/IMU (one robot per host thread, see sim_batch) ----
+  static thread_local Chassis chassis;
+  static thread_local ImuMock imu;
+#else  // ---- Real PROS chassis/IMU ----
+static Chassis chassis;
+static pros::Imu imu(IMU_PORT > 0 ? IMU_PORT : 0);  // only touched when IMU_PORT > 0
+static pros::Gps gps(GPS_PORT > 0 ? GPS_PORT : 0);  // only touched when GPS_PORT > 0
+#endif
+
+// ---- IMU calibration ----
+// Started by initialize() and left to run while everything else comes up.
+#ifdef SIM
+static thread_local uint32_t imu_reset_ms = 0;
+static thread_local uint32_t imu_cal_ms = 0;
+#else
+static uint32_t imu_reset_ms = 0;
+#endif
+
+static bool imu_calibrated() {
+#ifdef SIM
+  return !imu.is_calibrating();
+#else
+  if (IMU_PORT <= 0) return false;
+  return pros::millis() - imu_reset_ms >= IMU_SETTLE_MS && !imu.is_calibrating();
+#endif
 }
 
-void initialize() {
+// ---- Sensor acquisition ----
+// Every device read for one tick, in one place.
+static Snapshot read_devices() {
+  Snapshot s{};
+  s.t_us = pros::micros();
+  chassis.read(s.pos_deg, s.rpm, s.mv);
+  s.imu_ready = imu_calibrated();
+  s.imu_heading_deg = s.imu_ready ? imu.get_heading() : 0.0;
 #ifndef SIM
-  mFL.set_gearing(GEARSET);  mFR.set_gearing(GEARSET);
-  mBL.set_gearing(GEARSET);  mBR.set_gearing(GEARSET);
-  mFL.set_encoder_units(ENCODERS); mFR.set_encoder_units(ENCODERS);
-  mBL.set_encoder_units(ENCODERS); mBR.set_encoder_units(ENCODERS);
-  mFL.set_reversed(REVERSED_FL); mFR.set_reversed(REVERSED_FR);
-  mBL.set_reversed(REVERSED_BL); mBR.set_reversed(REVERSED_BR);
+  if (s.imu_ready) s.imu_rate_dps = imu.get_gyro_rate().z;
+  if (GPS_PORT > 0) {
+    const pros::gps_position_s_t p = gps.get_position();
+    s.gps_x_m = p.x;
+    s.gps_y_m = p.y;
+    s.gps_heading_deg = gps.get_heading();
+    s.gps_error_m = gps.get_error();
+    s.gps_ready = std::isfinite(s.gps_x_m) && std::isfinite(s.gps_heading_deg) &&
+                  std::isfinite(s.gps_error_m);
+  }
+#endif
+  if (!std::isfinite(s.imu_heading_deg) || !std::isfinite(s.imu_rate_dps)) {  // PROS_ERR_F: unplugged since
+    s.imu_ready = false;
+    s.imu_heading_deg = s.imu_rate_dps = 0.0;
+  }
+  return s;
+}
+
+#ifdef SIM
+static thread_local Seqlock<Snapshot> snapshot;
+#else
+static Seqlock<Snapshot> snapshot;
+#endif
+
+static std::atomic<SampleHook> sample_hooks[4];
+
+static void sample_tick() {
+  Snapshot s = read_devices();
+  s.seq = snapshot.version() + 1;
+  snapshot.store(s);
+  for (std::atomic<SampleHook>& h : sample_hooks)
+    if (SampleHook fn = h.load(std::memory_order_acquire)) fn(s);
+}
+
+// One above the drive loop (DEFAULT + 1), so each tick's sample lands before
+// drive() uses it.
+static control::Loop sensor_loop("sensors", 10, TASK_PRIORITY_DEFAULT + 2, sample_tick);
+
+// Without the loop there is no single writer to publish, so read directly.
+Snapshot sensors() { return sensor_loop.running() ? snapshot.load() : read_devices(); }
+void start_sensors() { sensor_loop.start(); }
+void stop_sensors() { sensor_loop.stop(); }
+bool sensors_running() { return sensor_loop.running(); }
 
-  if (IMU_PORT > 0) {
-    imu.reset();
-    for (int t=0; t<250 && imu.is_calibrating(); ++t) pros::delay(10);
+bool add_sample_hook(SampleHook fn) {
+  for (std::atomic<SampleHook>& h : sample_hooks) {
+    SampleHook empty = nullptr;
+    if (h.load() == fn || h.compare_exchange_strong(empty, fn)) return true;
   }
+  return false;
+}
+
+void remove_sample_hook(SampleHook fn) {
+  for (std::atomic<SampleHook>& h : sample_hooks) {
+    SampleHook mine = fn;
+    h.compare_exchange_strong(mine, nullptr);
+  }
+}
+
+// ---- Wheel velocity control ----
+struct WheelVel { double target_rpm = 0.0; uint32_t t_ms = 0; bool primed = false; };
+#ifdef SIM
+static thread_local VelGains vel_gains;
+static thread_local WheelVel wheel_vel[4];
+#else
+static VelGains vel_gains;
+static WheelVel wheel_vel[4];
 #endif
+
+void set_velocity_gains(const VelGains& g) { vel_gains = g; }
+const VelGains& velocity_gains() { return vel_gains; }
+
+// Feedforward + P for one wheel; returns millivolts for move_voltage().
+static int wheel_mv(double measured_rpm, WheelVel& st, double target_rpm, uint32_t now) {
+  const VelGains& g = vel_gains;
+  // Target acceleration since the last call; none after a pause (first call,
+  // or the helpers had the motors), so the first tick does not spike.
+  const uint32_t dt_ms = now - st.t_ms;
+  const double accel = (st.primed && dt_ms > 0 && dt_ms <= 100)
+                           ? (target_rpm - st.target_rpm) * 1000.0 / dt_ms : 0.0;
+  const bool was_moving = st.primed && st.target_rpm != 0.0;
+  st = WheelVel{target_rpm, now, true};
+
+  // Sticks centered: coast like move(0), but brake through the one tick where
+  // the target drops to zero.
+  if (target_rpm == 0.0 && !was_moving) return 0;
+  double v = g.kV * target_rpm + g.kA * accel + g.kP * (target_rpm - measured_rpm);
+  if (target_rpm != 0.0) v += std::copysign(g.kS, target_rpm);
+  return static_cast<int>(std::max(-12.0, std::min(12.0, v)) * 1000.0);
 }
 
-double heading_deg() {
-#if defined(SIM)
-  return imu.get_heading();
+void initialize() {
+  // IMU first: its ~2 s calibration overlaps everything after it.
+#ifdef SIM
+  imu = ImuMock{};
+  imu.cal_ms = imu_cal_ms;
+  imu.reset();
 #else
-  if (IMU_PORT > 0 && !imu.is_calibrating()) return imu.get_heading();
-  return 0.0;
+  if (IMU_PORT > 0) imu.reset(false);
 #endif
+  imu_reset_ms = pros::millis();
+
+#ifdef SIM
+  chassis = Chassis{};
+#endif
+  chassis.configure();
+  for (WheelVel& w : wheel_vel) w = WheelVel{};
+}
+
+ImuState imu_state() {
+#ifndef SIM
+  if (IMU_PORT <= 0) return ImuState::NONE;
+#endif
+  if (sensors().imu_ready) return ImuState::READY;
+  return pros::millis() - imu_reset_ms >= IMU_CAL_TIMEOUT_MS ? ImuState::FAILED : ImuState::CALIBRATING;
 }
 
-// Normalize 4 wheel values to [-127..127]
-static void normalize(double &fl, double &fr, double &bl, double &br) {
-  const double maxmag = std::max({std::abs(fl), std::abs(fr), std::abs(bl), std::abs(br), 127.0});
-  if (maxmag > 127.0) {
-    const double k = 127.0 / maxmag;
-    fl *= k; fr *= k; bl *= k; br *= k;
+const char* imu_label() {
+  switch (imu_state()) {
+    case ImuState::CALIBRATING: return "IMU calibrating (robot-centric)";
+    case ImuState::FAILED:      return "IMU failed (robot-centric)";
+    default:                    return "";
+  }
+}
+
+double heading_deg() { return heading_deg(sensors()); }
+
+double heading_deg(const Snapshot& sn) {
+  if (!sn.imu_ready) return 0.0;
+  // PROS reports the heading CW; drive() and Odom2WIMU turn CCW-positive.
+  const double h = 360.0 - sn.imu_heading_deg;
+  return h >= 360.0 ? h - 360.0 : h;
+}
+
+#ifdef SIM
+void sim_set_heading(double deg) {
+  const double h = std::fmod(360.0 - deg, 360.0);  // the mock reports CW, like PROS
+  imu.heading_deg = h < 0.0 ? h + 360.0 : h;
+}
+
+void sim_set_imu_calibration_ms(uint32_t ms) { imu_cal_ms = ms; }
+#endif
+
+void drive(int fwd, int str, int rot, bool field_centric, const Shaping& sh) {
+  double df = shape(fwd, sh);
+  double ds = shape(str, sh);
+  const double dr = shape(rot, sh);
+
+  const Snapshot sn = sensors();
+  if (field_centric && sn.imu_ready) {
+    const double th = heading_deg(sn) * (M_PI / 180.0);
+    const double c = std::cos(th), s = std::sin(th);
+    const double rs =  ds * c + df * s;   // new strafe
+    const double rf =  df * c - ds * s;   // new forward
+    ds = rs; df = rf;
   }
+
+  const WheelMix w = mix(df, ds, dr);
+
+  if (!VELOCITY_CONTROL) {
+    const int v[4] = {static_cast<int>(w.fl), static_cast<int>(w.fr),
+                      static_cast<int>(w.bl), static_cast<int>(w.br)};
+    chassis.move(v);
+    return;
+  }
+
+  const uint32_t now = now_ms();
+  const double k = gear_rpm() / 127.0;
+  const int mv[4] = {wheel_mv(sn.rpm[0], wheel_vel[0], w.fl * k, now),
+                     wheel_mv(sn.rpm[1], wheel_vel[1], w.fr * k, now),
+                     wheel_mv(sn.rpm[2], wheel_vel[2], w.bl * k, now),
+                     wheel_mv(sn.rpm[3], wheel_vel[3], w.br * k, now)};
+  chassis.move_voltage(mv);
 }
 
-void drive(int fwd, int str, int rot, bool field_centric) {
-  fwd = deadband(fwd);
-  str = deadband(str);
-  rot = deadband(rot);
+// ---- Closed-loop autonomous helpers ----
+#ifdef SIM
+static thread_local PosGains gains;  // per host thread, so sim_tune can run candidates in parallel
+static thread_local MotionLimits limits;
+#else
+static PosGains gains;
+static MotionLimits limits;
+#endif
+
+void set_position_gains(const PosGains& g) { gains = g; }
+const PosGains& position_gains() { return gains; }
+void set_motion_limits(const MotionLimits& l) { limits = l; }
+const MotionLimits& motion_limits() { return limits; }
+
+static bool motion_stopped(uint32_t id);
 
-  double df = SQUARE_INPUTS ? signed_square(fwd) : fwd;
-  double ds = SQUARE_INPUTS ? signed_square(str) : str;
-  double dr = SQUARE_INPUTS ? signed_square(rot) : rot;
+// Move each wheel by its target (wheel degrees) with the PosGains loop,
+// following one profile (scaled per wheel) under the axis limits, with the
+// profile velocity capped at `speed` rpm. A nonzero `motion_id` is the motion
+// task's move, which ends early once it is cancelled or superseded.
+static MoveResult move_wheels(Axis axis, double fl, double fr, double bl, double br, int speed,
+                              uint32_t motion_id = 0) {
+  const double target[4] = {fl, fr, bl, br};
+  const PosGains g = gains;
+  const VelGains ff = vel_gains;
+  const double dt = 0.01;
+  const double vmax = 12.0;
 
-  #ifndef SIM
-    if (field_centric && IMU_PORT > 0 && !imu.is_calibrating()) {
-      const double th = heading_deg() * (M_PI / 180.0);
-      const double c = std::cos(th), s = std::sin(th);
-      const double rs =  ds * c + df * s;   // new strafe
-      const double rf =  df * c - ds * s;   // new forward
-      ds = rs; df = rf;
+  profile::Limits lim = limits[axis];
+  lim.v = std::min(lim.v, std::abs(speed) * 6.0);  // rpm -> deg/s
+  const double span = std::max({std::abs(fl), std::abs(fr), std::abs(bl), std::abs(br)});
+  const profile::Profile prof(span, lim);
+  double integ[4] = {0, 0, 0, 0};
+
+  // Positions relative to the start, from the same snapshot stream as the
+  // loop below (a tare would not show up until the next sample).
+  const Snapshot start = sensors();
+  MoveResult r{0, 0.0, 0.0, false};
+  const uint32_t t0 = now_ms();
+  uint32_t in_tol_since = 0;
+  bool in_tol = false;
+  while (!(motion_id && motion_stopped(motion_id))) {
+    const uint32_t t = now_ms() - t0;
+    const profile::State sp = prof.at(t / 1000.0);
+    const bool moving = t / 1000.0 < prof.duration();
+    const Snapshot sn = sensors();
+    bool all_in = true;
+    int mv[4];
+    for (int k = 0; k < 4; ++k) {
+      const double scale = span > 0.0 ? target[k] / span : 0.0;
+      const double p_sp = scale * sp.p, v_sp = scale * sp.v, a_sp = scale * sp.a;
+      const double pos = sn.pos_deg[k] - start.pos_deg[k];
+      const double err = p_sp - pos;
+      const double vel = sn.rpm[k] * 6.0;  // rpm -> deg/s
+      r.overshoot_deg = std::max(r.overshoot_deg, target[k] >= 0 ? pos - target[k] : target[k] - pos);
+      const bool near = std::abs(target[k] - pos) <= g.tol_deg;
+      all_in = all_in && near;
+
+      integ[k] += err * dt;
+      if (g.kI > 0.0) integ[k] = std::max(-vmax / g.kI, std::min(vmax / g.kI, integ[k]));
+      double u = g.kP * err + g.kI * integ[k] + g.kD * (v_sp - vel);
+      if (moving) u += std::copysign(ff.kS, v_sp) * (v_sp != 0.0) + (ff.kV * v_sp + ff.kA * a_sp) / 6.0;
+      else if (!near) u += std::copysign(g.kS, err);
+      u = std::max(-vmax, std::min(vmax, u));
+      mv[k] = static_cast<int>(u * 1000.0);
     }
-  #else
-    // In SIM, we always allow field_centric off (IMU mock is absolute anyway).
-    if (field_centric) {
-      const double th = heading_deg() * (M_PI / 180.0);
-      const double c = std::cos(th), s = std::sin(th);
-      const double rs =  ds * c + df * s;
-      const double rf =  df * c - ds * s;
-      ds = rs; df = rf;
+    chassis.move_voltage(mv);
+
+    if (all_in && !moving) {
+      if (!in_tol) { in_tol = true; in_tol_since = t; }
+      if (t - in_tol_since >= g.settle_ms) { r.settled = true; break; }
+    } else {
+      in_tol = false;
     }
-  #endif
-
-  // X-drive kinematics: +df=forward, +ds=right, +dr=CW
-  double fl = df + ds + dr;
-  double fr = df - ds - dr;
-  double bl = df - ds + dr;
-  double br = df + ds - dr;
-
-  normalize(fl, fr, bl, br);
-
-  mFL.move(static_cast<int>(fl));
-  mFR.move(static_cast<int>(fr));
-  mBL.move(static_cast<int>(bl));
-  mBR.move(static_cast<int>(br));
-}
-
-// ---- Simple open-loop autonomous helpers ----
-static void reset_positions() {
-  #ifndef SIM
-  mFL.tare_position(); mFR.tare_position();
-  mBL.tare_position(); mBR.tare_position();
-  #endif
-}
-static void move_all_relative(double fl, double fr, double bl, double br, int speed) {
-  #ifndef SIM
-  mFL.move_relative(fl, speed);
-  mFR.move_relative(fr, speed);
-  mBL.move_relative(bl, speed);
-  mBR.move_relative(br, speed);
-  #endif
-}
-static bool any_busy(double target_deg, double tol = 5.0) {
-  #ifndef SIM
-  const double T = std::max(0.0, std::abs(target_deg) - tol);
-  return (std::abs(mFL.get_position()) < T) ||
-         (std::abs(mFR.get_position()) < T) ||
-         (std::abs(mBL.get_position()) < T) ||
-         (std::abs(mBR.get_position()) < T);
-  #else
-  return false;
-#endif
+    if (t >= g.timeout_ms) break;
+    sleep_ms(10);
+  }
+
+  chassis.stop();
+  const Snapshot end = sensors();
+  for (int k = 0; k < 4; ++k) r.error_deg = std::max(r.error_deg, std::abs(target[k] - (end.pos_deg[k] - start.pos_deg[k])));
+  r.ms = now_ms() - t0;
+  return r;
 }
 
-void drive_forward_deg(double wheel_deg, int speed) {
-  reset_positions();
-  move_all_relative(wheel_deg, wheel_deg, wheel_deg, wheel_deg, speed);
-  #ifndef SIM
-  pros::delay(10);
-  while (any_busy(wheel_deg)) pros::delay(10);
-  #endif
+MoveResult drive_forward_deg(double wheel_deg, int speed) {
+  return move_wheels(Axis::Forward, wheel_deg, wheel_deg, wheel_deg, wheel_deg, speed);
 }
-void strafe_right_deg(double wheel_deg, int speed) {
-  reset_positions();
-  move_all_relative(+wheel_deg, -wheel_deg, -wheel_deg, +wheel_deg, speed);
-  #ifndef SIM
-  pros::delay(10);
-  while (any_busy(wheel_deg)) pros::delay(10);
-  #endif
+MoveResult strafe_right_deg(double wheel_deg, int speed) {
+  return move_wheels(Axis::Strafe, +wheel_deg, -wheel_deg, -wheel_deg, +wheel_deg, speed);
 }
-void turn_cw_deg(double wheel_deg, int speed) {
-  reset_positions();
-  move_all_relative(+wheel_deg, -wheel_deg, +wheel_deg, -wheel_deg, speed);
-  #ifndef SIM
-  pros::delay(10);
-  while (any_busy(wheel_deg)) pros::delay(10);
-  #endif
+MoveResult turn_cw_deg(double wheel_deg, int speed) {
+  return move_wheels(Axis::Rotate, +wheel_deg, -wheel_deg, +wheel_deg, -wheel_deg, speed);
 }
 
-// ---------- LCD TELEMETRY ----------
+// ---- Motion task ----
+// One persistent task runs the moves. start_motion() writes the request slot
+// and publishes its id in `req` under the scheduler lock, and the worker
+// copies both out under it, so a move never mixes two requests. The worker
+// alone ends a move: it stores the result, then publishes the id in
+// `finished` (release) and wakes the tasks waiting on it, still under the
+// lock; done() reads the ids lock-free (acquire). A move stops early once
+// `req` moves past it or `cancel_id` names it.
+//
+// Waiters register and unregister themselves under the lock, in one of
+// MAX_WAITERS slots, and only those on a move at or before the one that just
+// ended are notified. The competition framework deletes autonomous() at the
+// end of its period, maybe mid-wait, so stop_motion() (which disabled() and
+// opcontrol() call first) also drops every registration.
 #ifndef SIM
-static pros::Task* telemetry_task = nullptr;
+// The PROS kernel's scheduler lock (FreeRTOS vTaskSuspendAll): exported by
+// libpros, not declared in its headers.
+extern "C" {
+void rtos_suspend_all(void);
+int32_t rtos_resume_all(void);
+}
 #endif
 
-#ifndef SIM
-static void telemetry_loop(void*) {
-  pros::lcd::initialize(); // safe to call if already initialized
+// Holds off every other task; nothing inside may block.
+struct SchedLock {
+  SchedLock() { rtos_suspend_all(); }
+  ~SchedLock() { rtos_resume_all(); }
+  SchedLock(const SchedLock&) = delete;
+  SchedLock& operator=(const SchedLock&) = delete;
+};
+
+struct MoveRequest {
+  Axis axis;
+  double target[4];
+  int speed;
+};
+
+struct Waiter {
+  pros::task_t task;  // blocked in wait() on move `id`
+  uint32_t id;
+};
+constexpr size_t MAX_WAITERS = 4;
+
+struct MotionState {
+  MoveRequest slot{Axis::Forward, {0, 0, 0, 0}, 0};  // latest request (lock)
+  std::atomic<uint32_t> req{0};         // id of the latest request
+  std::atomic<uint32_t> cancel_id{0};   // move asked to stop
+  std::atomic<uint32_t> finished{0};    // id whose result is published
+  MoveResult result{0, 0.0, 0.0, false};  // worker, under the lock
+  Waiter waiters[MAX_WAITERS] = {};     // lock
+  pros::task_t worker = nullptr;
+};
+#ifdef SIM
+static thread_local MotionState motion;
+#else
+static MotionState motion;
+#endif
+
+// Signed distance, so ids keep ordering across wraparound.
+static bool id_reached(uint32_t id, uint32_t target) { return static_cast<int32_t>(id - target) >= 0; }
+
+static bool motion_stopped(uint32_t id) {
+  return motion.req.load(std::memory_order_acquire) != id ||
+         motion.cancel_id.load(std::memory_order_acquire) == id;
+}
+
+// Under the lock: wake the waiters on `last_done` or older moves.
+static void wake_waiters(uint32_t last_done) {
+  for (Waiter& w : motion.waiters)
+    if (w.task && id_reached(last_done, w.id)) {
+      pros::Task(w.task).notify();
+      w = Waiter{};
+    }
+}
+
+static void motion_task() {
+  uint32_t ran = 0;
   while (true) {
-    // Read commanded voltage (mV). Sign indicates direction.
-    const double vFL = mFL.get_voltage();
-    const double vFR = mFR.get_voltage();
-    const double vBL = mBL.get_voltage();
-    const double vBR = mBR.get_voltage();
+    pros::Task::notify_take(true, TIMEOUT_MAX);
+    uint32_t id;
+    MoveRequest rq;
+    {
+      const SchedLock lock;
+      id = motion.req.load(std::memory_order_relaxed);
+      rq = motion.slot;
+      wake_waiters(id - 1);  // on requests superseded before they ran
+    }
+    if (id == ran) continue;  // nothing new (requests in between were superseded unrun)
+    ran = id;
+    const MoveResult r = move_wheels(rq.axis, rq.target[0], rq.target[1], rq.target[2], rq.target[3],
+                                     rq.speed, id);
+    const SchedLock lock;
+    motion.result = r;
+    motion.finished.store(id, std::memory_order_release);
+    wake_waiters(id);
+  }
+}
 
-    // Convert to percent of full scale (~12000 mV on V5)
-    auto pct = [](double mv) {
-      const double p = (mv / 12000.0) * 100.0;
-      // clamp for safety
-      if (p > 100.0) return 100.0;
-      if (p < -100.0) return -100.0;
-      return p;
-    };
+static Motion start_motion(Axis axis, double fl, double fr, double bl, double br, int speed) {
+  if (!motion.worker)
+    motion.worker = static_cast<pros::task_t>(
+        pros::Task(motion_task, TASK_PRIORITY_DEFAULT + 1, TASK_STACK_DEPTH_DEFAULT, "xdrive-motion"));
+  uint32_t id;
+  {
+    const SchedLock lock;
+    motion.slot = MoveRequest{axis, {fl, fr, bl, br}, speed};
+    id = motion.req.load(std::memory_order_relaxed) + 1;
+    if (id == 0) id = 1;  // 0 is Motion(): no move
+    motion.req.store(id, std::memory_order_release);  // also ends the running move
+  }
+  pros::Task(motion.worker).notify();
+  return Motion(id);
+}
 
-    // Direction labels & magnitude
-    const double pFL = pct(vFL), pFR = pct(vFR), pBL = pct(vBL), pBR = pct(vBR);
-    auto dir = [](double p){ return p >= 0 ? "FWD" : "REV"; };
+bool Motion::done() const {
+  return id_ != motion.req.load(std::memory_order_acquire) ||
+         motion.finished.load(std::memory_order_acquire) == id_;
+}
 
-    // Optional: show actual velocity (RPM) to confirm motion
-    const double rFL = mFL.get_actual_velocity();
-    const double rFR = mFR.get_actual_velocity();
-    const double rBL = mBL.get_actual_velocity();
-    const double rBR = mBR.get_actual_velocity();
+MoveResult Motion::result() const {
+  const SchedLock lock;
+  const bool mine = id_ == motion.req.load(std::memory_order_relaxed) &&
+                    motion.finished.load(std::memory_order_relaxed) == id_;
+  return mine ? motion.result : MoveResult{0, 0.0, 0.0, false};
+}
 
-    // Print to LCD (rows 0–7)
-    pros::lcd::print(0, "X-Drive Telemetry");
-    pros::lcd::print(1, "FL: %4.0f%% %s | %4.0f rpm", fabs(pFL), dir(pFL), rFL);
-    pros::lcd::print(2, "FR: %4.0f%% %s | %4.0f rpm", fabs(pFR), dir(pFR), rFR);
-    pros::lcd::print(3, "BL: %4.0f%% %s | %4.0f rpm", fabs(pBL), dir(pBL), rBL);
-    pros::lcd::print(4, "BR: %4.0f%% %s | %4.0f rpm", fabs(pBR), dir(pBR), rBR);
+bool Motion::wait(uint32_t timeout_ms) {
+  const pros::task_t self = static_cast<pros::task_t>(pros::Task::current());
+#ifdef SIM
+  // The host thread is not a task and cannot block on a notification;
+  // pros::delay() there runs the emulated tasks instead.
+  if (!self) {
+    const uint32_t t0 = now_ms();
+    while (!done() && now_ms() - t0 < timeout_ms) pros::delay(10);
+    return done();
+  }
+#endif
+  {
+    const SchedLock lock;
+    if (done()) return true;
+    Waiter* slot = nullptr;
+    for (Waiter& w : motion.waiters)
+      if (!w.task) { slot = &w; break; }
+    if (!slot) return false;  // MAX_WAITERS tasks already waiting
+    *slot = Waiter{self, id_};
+  }
+  // The worker notifies once the move is over or superseded; done() is only
+  // still false after a wakeup if the notification was someone else's.
+  const uint32_t t0 = now_ms();
+  for (uint32_t waited = 0; !done() && waited < timeout_ms; waited = now_ms() - t0)
+    pros::Task::notify_take(true, timeout_ms - waited);
+  const SchedLock lock;
+  for (Waiter& w : motion.waiters)
+    if (w.task == self) w = Waiter{};
+  return done();
+}
 
-    // If you only want to show when powered, you could blank lines when |pct| < 1–2%.
+void Motion::cancel() { motion.cancel_id.store(id_, std::memory_order_release); }
 
-    pros::delay(100); // update ~10 Hz
+void stop_motion() {
+  {
+    const SchedLock lock;
+    for (Waiter& w : motion.waiters) w = Waiter{};  // may be tasks the framework deleted mid-wait
   }
+  Motion(motion.req.load(std::memory_order_acquire)).cancel();
 }
+
+#ifdef SIM
+// sim::kill_all_tasks() deleted the worker and any waiters: the next move
+// starts a new worker, and the last one reads as done (cancelled).
+static void forget_motion_tasks() {
+  motion.worker = nullptr;
+  for (Waiter& w : motion.waiters) w = Waiter{};
+  motion.result = MoveResult{0, 0.0, 0.0, false};
+  motion.finished.store(motion.req.load(std::memory_order_relaxed), std::memory_order_release);
+}
+[[maybe_unused]] static const bool motion_hooked = (sim::on_kill_all_tasks(forget_motion_tasks), true);
 #endif
 
-void start_telemetry() {
-  #ifndef SIM
-  if (!telemetry_task) {
-    telemetry_task = new pros::Task(telemetry_loop, nullptr, "xdrive-telemetry");
+Motion drive_forward_async(double wheel_deg, int speed) {
+  return start_motion(Axis::Forward, wheel_deg, wheel_deg, wheel_deg, wheel_deg, speed);
+}
+Motion strafe_right_async(double wheel_deg, int speed) {
+  return start_motion(Axis::Strafe, +wheel_deg, -wheel_deg, -wheel_deg, +wheel_deg, speed);
+}
+Motion turn_cw_async(double wheel_deg, int speed) {
+  return start_motion(Axis::Rotate, +wheel_deg, -wheel_deg, +wheel_deg, -wheel_deg, speed);
+}
+
+// ---------- LCD TELEMETRY ----------
+static void telemetry_tick() {
+  const Snapshot sn = sensors();
+
+  // Commanded voltage (mV) as percent of full scale (~12000 mV on V5).
+  // Sign indicates direction.
+  auto pct = [](double mv) {
+    const double p = (mv / 12000.0) * 100.0;
+    // clamp for safety
+    if (p > 100.0) return 100.0;
+    if (p < -100.0) return -100.0;
+    return p;
+  };
+
+  // Direction labels & magnitude
+  const double pFL = pct(sn.mv[0]), pFR = pct(sn.mv[1]), pBL = pct(sn.mv[2]), pBR = pct(sn.mv[3]);
+  auto dir = [](double p){ return p >= 0 ? "FWD" : "REV"; };
+
+  // Actual velocity (RPM) to confirm motion
+  const double rFL = sn.rpm[0], rFR = sn.rpm[1], rBL = sn.rpm[2], rBR = sn.rpm[3];
+
+  // Print to LCD (rows 0–7)
+  pros::lcd::print(0, "X-Drive Telemetry %s", imu_label());
+  pros::lcd::print(1, "FL: %4.0f%% %s | %4.0f rpm", fabs(pFL), dir(pFL), rFL);
+  pros::lcd::print(2, "FR: %4.0f%% %s | %4.0f rpm", fabs(pFR), dir(pFR), rFR);
+  pros::lcd::print(3, "BL: %4.0f%% %s | %4.0f rpm", fabs(pBL), dir(pBL), rBL);
+  pros::lcd::print(4, "BR: %4.0f%% %s | %4.0f rpm", fabs(pBR), dir(pBR), rBR);
+
+  // If you only want to show when powered, you could blank lines when |pct| < 1–2%.
+
+  // Lines 5-7: timing of the fixed-rate control loops, three per 2 s page.
+  // Loops register in link order, so paging is what shows every one.
+  constexpr size_t LINES = 3;
+  constexpr uint32_t PAGE_MS = 2000;
+  const size_t n = control::loop_count();
+  const size_t pages = (n + LINES - 1) / LINES;
+  const size_t first = pages ? (now_ms() / PAGE_MS) % pages * LINES : 0;
+  for (size_t k = 0; k < LINES; ++k) {
+    if (first + k >= n) { pros::lcd::clear_line(5 + k); continue; }
+    const control::Loop& l = control::loop(first + k);
+    const control::Stats& st = l.stats();
+    pros::lcd::print(5 + k, "%-9s %3u Hz ovr %u wcet %u jit %u us", l.name(),
+                     (unsigned)(1000 / l.period_ms()), (unsigned)st.overruns,
+                     (unsigned)st.wcet_us, (unsigned)st.jitter_max_us);
   }
-  #endif
+}
+
+// ~10 Hz, below the drive loop so screen updates never delay it
+static control::Loop telemetry("telemetry", 100, TASK_PRIORITY_DEFAULT - 2, telemetry_tick);
+
+void start_telemetry() {
+#ifndef SIM
+  if (LVGL_DASHBOARD) { dashboard::start(); return; }
+#endif
+  pros::lcd::initialize(); // safe to call if already initialized
+  telemetry.start();
 }
 
 void stop_telemetry() {
-  #ifndef SIM
-  if (telemetry_task) {
-    telemetry_task->remove();
-    delete telemetry_task;
-    telemetry_task = nullptr;
-  }
-  #endif
+#ifndef SIM
+  if (LVGL_DASHBOARD) { dashboard::stop(); return; }
+#endif
+  telemetry.stop();
 }
 
 } // namespace xdrive